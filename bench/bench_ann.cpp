@@ -0,0 +1,102 @@
+/*
+ * File:   bench_ann.cpp
+ *
+ * DataLoader batches/s, FCLayer::forward and BaseModel::predict throughput.
+ */
+
+#include "harness.h"
+#include "ann/BaseModel.h"
+#include "ann/FCLayer.h"
+#include "ann/ReLU.h"
+#include "ann/Softmax.h"
+#include "ann/dataloader.h"
+#include "util/AllocTracker.h"
+
+static void bench_dataloader(BenchHarness& harness){
+    const size_t nsamples = 4096, nfeatures = 64;
+    xt::xarray<double> X = xt::random::randn<double>({nsamples, nfeatures});
+    xt::xarray<double> T = xt::random::randint<int>({nsamples}, 0, 10);
+    TensorDataset<double, double> dataset(X, T);
+    
+    for(int batch_size: {16, 64, 256}){
+        DataLoader<double, double> loader(&dataset, batch_size, true, false, 0);
+        double nbatches = (nsamples + batch_size - 1)/batch_size;
+        harness.run("DataLoader/epoch/batch:" + to_string(batch_size), nbatches, [&](long iters){
+            BenchTimer timer;
+            timer.start();
+            for(long it=0; it < iters; it++){
+                for(auto batch: loader) do_not_optimize(batch.getData().data());
+            }
+            return timer.stop();
+        });
+    }
+}
+
+static void bench_fclayer(BenchHarness& harness){
+    const int n_in = 256, n_out = 256;
+    FCLayer layer(n_in, n_out, true);
+    layer.set_training(false);
+    for(size_t batch: {1, 32, 256}){
+        xt::xarray<double> X = xt::random::randn<double>({batch, (size_t)n_in});
+        harness.run("FCLayer/forward/256x256/batch:" + to_string(batch), batch, [&](long iters){
+            BenchTimer timer;
+            timer.start();
+            for(long it=0; it < iters; it++) do_not_optimize(layer.forward(X).data());
+            return timer.stop();
+        }, layer.flop_count(X));
+    }
+}
+
+static void bench_predict(BenchHarness& harness){
+    Layer* seq[] = {new FCLayer(784, 256), new ReLU(), new FCLayer(256, 128), new ReLU(),
+                    new FCLayer(128, 10), new Softmax()};
+    BaseModel model(seq, 6);
+    model.eval();
+    for(size_t batch: {1, 64, 512}){
+        xt::xarray<double> X = xt::random::randn<double>({batch, (size_t)784});
+        double flops = 2.0*batch*(784*256 + 256*128 + 128*10);
+        harness.run("BaseModel/predict/mlp784/batch:" + to_string(batch), batch, [&](long iters){
+            BenchTimer timer;
+            timer.start();
+            for(long it=0; it < iters; it++) do_not_optimize(model.predict(X).data());
+            return timer.stop();
+        }, flops);
+        harness.run("BaseModel/predict_ctx/mlp784/batch:" + to_string(batch), batch, [&](long iters){
+            InferenceContext ctx;
+            BenchTimer timer;
+            timer.start();
+            for(long it=0; it < iters; it++) do_not_optimize(model.predict(X, ctx).data());
+            return timer.stop();
+        }, flops);
+    }
+}
+
+//per-subsystem breakdown of one DataLoader epoch and one predict call
+static void report_allocations(BenchHarness& harness){
+    if(!AllocTracker::enabled() || !harness.enabled("Alloc/")) return;
+    xt::xarray<double> X = xt::random::randn<double>({(size_t)1024, (size_t)784});
+    xt::xarray<double> T = xt::random::randint<int>({(size_t)1024}, 0, 10);
+    TensorDataset<double, double> dataset(X, T);
+    DataLoader<double, double> loader(&dataset, 64, true, false, 0);
+    {
+        AllocRegion region("Alloc/DataLoader/epoch/batch:64");
+        for(auto batch: loader) do_not_optimize(batch.getData().data());
+        region.println();
+    }
+    
+    Layer* seq[] = {new FCLayer(784, 256), new ReLU(), new FCLayer(256, 10), new Softmax()};
+    BaseModel model(seq, 4);
+    model.eval();
+    {
+        AllocRegion region("Alloc/BaseModel/predict/batch:1024");
+        do_not_optimize(model.predict(X).data());
+        region.println();
+    }
+}
+
+void bench_ann(BenchHarness& harness){
+    bench_dataloader(harness);
+    bench_fclayer(harness);
+    bench_predict(harness);
+    report_allocations(harness);
+}
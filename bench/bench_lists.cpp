@@ -0,0 +1,499 @@
+/*
+ * File:   bench_lists.cpp
+ *
+ * List benchmarks, in the order they are defined and run:
+ *   >> add, insert, removeAt, get and indexOf at several sizes, for every
+ *      list type
+ *   >> XArrayList growth policies on large appends
+ *   >> many tiny lists: XArrayList vs XSmallList
+ *   >> snapshot of a large list: XArrayList deep copy vs PersistentList
+ *   >> FIFO window: XArrayList / DLinkedList / XDeque
+ *   >> XHeap push/pop and top-k selection: binary vs 4-ary
+ *   >> collecting results from worker threads: mutex + XArrayList vs
+ *      ConcurrentXArrayList
+ *   >> producer/consumer threads: mutex + DLinkedList vs MPMCQueue / SPSCQueue
+ *   >> objects the caller owns: DLinkedList<T*> vs IntrusiveDLinkedList
+ *   >> slice of a list: copy vs subList
+ *   >> sorting XArrayList and DLinkedList
+ */
+
+#include "harness.h"
+#include "list/listheader.h"
+#include "list/XSmallList.h"
+#include "list/PersistentList.h"
+#include "list/XDeque.h"
+#include "list/XHeap.h"
+#include "list/ConcurrentXArrayList.h"
+#include "list/ConcurrentQueue.h"
+#include "list/IntrusiveDLinkedList.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "util/Point.h"  //defines operator<<, so no other bench source may include it
+
+static const int SIZES[] = {100, 1000, 10000};
+
+//sum of get(0..n-1); DLinkedList walks with a cursor, as its callers should
+template <class L>
+static long sum_sequential(L& list, int n){
+    long sum = 0;
+    for(int i=0; i < n; i++) sum += list.get(i);
+    return sum;
+}
+static long sum_sequential(DLinkedList<int>& list, int n){
+    DLinkedList<int>::Cursor cursor;
+    long sum = 0;
+    for(int i=0; i < n; i++) sum += list.get(i, cursor);
+    return sum;
+}
+
+template <class L>
+static void bench_list(BenchHarness& harness, string type){
+    for(int n: SIZES){
+        string suffix = "/" + to_string(n);
+        
+        harness.run(type + "/add" + suffix, n, [n](long iters){
+            BenchTimer timer;
+            for(long it=0; it < iters; it++){
+                timer.start();
+                L list;
+                for(int i=0; i < n; i++) list.add(i);
+                do_not_optimize(list.size());
+                timer.stop();
+            }
+            return timer.elapsed();
+        });
+        
+        harness.run(type + "/insert_front" + suffix, n, [n](long iters){
+            BenchTimer timer;
+            for(long it=0; it < iters; it++){
+                L list;
+                timer.start();
+                for(int i=0; i < n; i++) list.add(0, i);
+                do_not_optimize(list.size());
+                timer.stop();
+            }
+            return timer.elapsed();
+        });
+        
+        harness.run(type + "/insert_middle" + suffix, n, [n](long iters){
+            BenchTimer timer;
+            for(long it=0; it < iters; it++){
+                L list;
+                timer.start();
+                for(int i=0; i < n; i++) list.add(list.size()/2, i);
+                do_not_optimize(list.size());
+                timer.stop();
+            }
+            return timer.elapsed();
+        });
+        
+        harness.run(type + "/removeAt_front" + suffix, n, [n](long iters){
+            BenchTimer timer;
+            for(long it=0; it < iters; it++){
+                L list;
+                for(int i=0; i < n; i++) list.add(i);
+                timer.start();
+                while(!list.empty()) do_not_optimize(list.removeAt(0));
+                timer.stop();
+            }
+            return timer.elapsed();
+        });
+        
+        harness.run(type + "/get_sequential" + suffix, n, [n](long iters){
+            L list;
+            for(int i=0; i < n; i++) list.add(i);
+            BenchTimer timer;
+            timer.start();
+            for(long it=0; it < iters; it++) do_not_optimize(sum_sequential(list, n));
+            return timer.stop();
+        });
+        
+        harness.run(type + "/indexOf_missing" + suffix, n, [n](long iters){
+            L list;
+            for(int i=0; i < n; i++) list.add(i);
+            BenchTimer timer;
+            timer.start();
+            for(long it=0; it < iters; it++) do_not_optimize(list.indexOf(-1));
+            return timer.stop();
+        });
+    }
+}
+
+//append 1M items under each growth policy; the counter is the final capacity
+//in bytes, i.e. how much memory the list holds on to
+static void bench_growth(BenchHarness& harness){
+    const int n = 1000000;
+    struct { string name; xarray_growth policy; } policies[] = {
+        {"double", XARRAY_GROW_DOUBLE}, {"half", XARRAY_GROW_HALF}, {"chunk", XARRAY_GROW_CHUNK}};
+    for(auto& entry: policies){
+        string name = "XArrayList/add_grow_" + entry.name + "/" + to_string(n);
+        int capacity = 0;
+        harness.run(name, n, [&](long iters){
+            BenchTimer timer;
+            for(long it=0; it < iters; it++){
+                timer.start();
+                XArrayList<int> list;
+                list.setGrowthPolicy(entry.policy, 65536);
+                for(int i=0; i < n; i++) list.add(i);
+                capacity = list.getCapacity();
+                timer.stop();
+            }
+            return timer.elapsed();
+        });
+        harness.counter(name, (double)capacity*sizeof(int));
+    }
+}
+
+//1000 short-lived lists of 3 items each, e.g. per-sample label lists;
+//run an ALLOC_TRACKING build to see the allocations per iteration
+template <class L>
+static void bench_tiny(BenchHarness& harness, string type){
+    const int nlists = 1000, nitems = 3;
+    harness.run(type + "/tiny_lists/1000x3", nlists, [](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            long sum = 0;
+            for(int l=0; l < nlists; l++){
+                L list;
+                for(int i=0; i < nitems; i++) list.add(l + i);
+                sum += list.get(nitems - 1);
+            }
+            do_not_optimize(sum);
+        }
+        return timer.stop();
+    });
+}
+
+//copy a 1M-item list, then change one item of the copy
+static void bench_snapshot(BenchHarness& harness){
+    const int n = 1000000;
+    XArrayList<int> array;
+    PersistentList<int> persistent;
+    for(int i=0; i < n; i++){
+        array.add(i);
+        persistent.add(i);
+    }
+    harness.run("XArrayList/copy_and_set/1000000", 1, [&](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            XArrayList<int> copy(array);
+            copy.get((int)(it % n)) = -1;
+            do_not_optimize(copy.size());
+        }
+        return timer.stop();
+    });
+    harness.run("PersistentList/snapshot_and_set/1000000", 1, [&](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            PersistentList<int> copy = persistent.snapshot();
+            copy.set((int)(it % n), -1);
+            do_not_optimize(copy.size());
+        }
+        return timer.stop();
+    });
+}
+
+//sliding window of 1000 items: append one at the back, drop one at the front
+template <class L>
+static void bench_fifo(BenchHarness& harness, string type){
+    const int window = 1000, steps = 10000;
+    harness.run(type + "/fifo_window/1000", steps, [](long iters){
+        L list;
+        for(int i=0; i < window; i++) list.add(i);
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            long sum = 0;
+            for(int i=0; i < steps; i++){
+                list.add(i);
+                sum += list.removeAt(0);
+            }
+            do_not_optimize(sum);
+        }
+        return timer.stop();
+    });
+}
+
+//push 100K random ints then pop them all; keep the 100 largest of a 1M stream
+template <int D>
+static void bench_heap(BenchHarness& harness, string type){
+    const int n = 100000, stream = 1000000, k = 100;
+    harness.run(type + "/push_pop/100000", n, [](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            XHeap<int, std::less<int>, D> heap;
+            heap.reserve(n);
+            unsigned int state = 12345;
+            for(int i=0; i < n; i++){
+                state = state*1664525u + 1013904223u;
+                heap.push((int)state);
+            }
+            long sum = 0;
+            while(!heap.empty()) sum += heap.pop();
+            do_not_optimize(sum);
+        }
+        return timer.stop();
+    });
+    harness.run(type + "/top100/1000000", stream, [](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            XHeap<int, std::greater<int>, D> heap;
+            heap.setBound(k);
+            unsigned int state = 12345;
+            for(int i=0; i < stream; i++){
+                state = state*1664525u + 1013904223u;
+                heap.push((int)state);
+            }
+            do_not_optimize(heap.top());
+        }
+        return timer.stop();
+    });
+}
+
+//4 threads append 250K ints each to one shared list
+static void bench_concurrent_add(BenchHarness& harness){
+    const int nthreads = 4, per_thread = 250000;
+    auto run_workers = [](std::function<void(int)> add){
+        vector<std::thread> workers;
+        for(int t=0; t < nthreads; t++){
+            workers.push_back(std::thread([=](){
+                for(int i=0; i < per_thread; i++) add(t*per_thread + i);
+            }));
+        }
+        for(std::thread& worker: workers) worker.join();
+    };
+    harness.run("XArrayList+mutex/concurrent_add/4x250000", nthreads*per_thread, [&](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            XArrayList<int> list;
+            std::mutex lock;
+            run_workers([&](int value){
+                std::lock_guard<std::mutex> guard(lock);
+                list.add(value);
+            });
+            do_not_optimize(list.size());
+        }
+        return timer.stop();
+    });
+    harness.run("ConcurrentXArrayList/concurrent_add/4x250000", nthreads*per_thread, [&](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            ConcurrentXArrayList<int> list;
+            run_workers([&](int value){ list.add(value); });
+            do_not_optimize(list.size());
+        }
+        return timer.stop();
+    });
+}
+
+//move 1M ints from producers to consumers through a queue of 1024 slots
+template <class Q>
+static double run_pipeline(long iters, int producers, int consumers, int n){
+    BenchTimer timer;
+    timer.start();
+    for(long it=0; it < iters; it++){
+        Q queue(1024);
+        std::atomic<long> sum(0);
+        vector<std::thread> workers;
+        for(int p=0; p < producers; p++){
+            workers.push_back(std::thread([&, p](){
+                for(int i=p; i < n; i += producers) queue.push(i);
+            }));
+        }
+        for(int c=0; c < consumers; c++){
+            workers.push_back(std::thread([&, c](){
+                long local = 0;
+                int share = n/consumers + (c < n%consumers? 1 : 0);
+                for(int i=0; i < share; i++) local += queue.pop();
+                sum += local;
+            }));
+        }
+        for(std::thread& worker: workers) worker.join();
+        do_not_optimize(sum.load());
+    }
+    return timer.stop();
+}
+
+//the DLinkedList + mutex + condition variables queue the pipelines used to build
+template <class T>
+class LockedListQueue {
+public:
+    LockedListQueue(int capacity): capacity(capacity){}
+    void push(T e){
+        std::unique_lock<std::mutex> guard(lock);
+        notFull.wait(guard, [this](){ return list.size() < capacity; });
+        list.add(e);
+        notEmpty.notify_one();
+    }
+    T pop(){
+        std::unique_lock<std::mutex> guard(lock);
+        notEmpty.wait(guard, [this](){ return !list.empty(); });
+        T item = list.removeAt(0);
+        notFull.notify_one();
+        return item;
+    }
+private:
+    DLinkedList<T> list;
+    int capacity;
+    std::mutex lock;
+    std::condition_variable notFull, notEmpty;
+};
+
+static void bench_queues(BenchHarness& harness){
+    const int n = 1000000;
+    harness.run("DLinkedList+mutex/pipeline_1x1/1000000", n, [](long iters){
+        return run_pipeline<LockedListQueue<int>>(iters, 1, 1, n);
+    });
+    harness.run("MPMCQueue/pipeline_1x1/1000000", n, [](long iters){
+        return run_pipeline<MPMCQueue<int>>(iters, 1, 1, n);
+    });
+    harness.run("SPSCQueue/pipeline_1x1/1000000", n, [](long iters){
+        return run_pipeline<SPSCQueue<int>>(iters, 1, 1, n);
+    });
+    harness.run("DLinkedList+mutex/pipeline_2x2/1000000", n, [](long iters){
+        return run_pipeline<LockedListQueue<int>>(iters, 2, 2, n);
+    });
+    harness.run("MPMCQueue/pipeline_2x2/1000000", n, [](long iters){
+        return run_pipeline<MPMCQueue<int>>(iters, 2, 2, n);
+    });
+}
+
+//link 10K existing objects, walk them summing a field, then unlink them one
+//by one given the object (removeItem search vs O(1) remove)
+struct BenchObject {
+    long value;
+    IntrusiveListHook hook;
+};
+
+static void bench_intrusive(BenchHarness& harness){
+    const int n = 10000;
+    vector<BenchObject> objects(n);
+    for(int i=0; i < n; i++) objects[i].value = i;
+    harness.run("DLinkedList<T*>/add_walk_remove/10000", n, [&](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            DLinkedList<BenchObject*> list;
+            for(int i=0; i < n; i++) list.add(&objects[i]);
+            long sum = 0;
+            for(BenchObject* obj: list) sum += obj->value;
+            for(int i=n-1; i >= 0; i -= 2) list.removeItem(&objects[i]);
+            do_not_optimize(sum + list.size());
+        }
+        return timer.stop();
+    });
+    harness.run("IntrusiveDLinkedList/add_walk_remove/10000", n, [&](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            IntrusiveDLinkedList<BenchObject, &BenchObject::hook> list;
+            for(int i=0; i < n; i++) list.add(&objects[i]);
+            long sum = 0;
+            for(BenchObject& obj: list) sum += obj.value;
+            for(int i=n-1; i >= 0; i -= 2) list.remove(&objects[i]);
+            do_not_optimize(sum + list.size());
+        }
+        return timer.stop();
+    });
+}
+
+//sum a 1000-item slice of a 100K-item list, copying it first or through a view
+static void bench_slice(BenchHarness& harness){
+    const int n = 100000, width = 1000;
+    XArrayList<double> list;
+    for(int i=0; i < n; i++) list.add(i);
+    harness.run("XArrayList/slice_copy/1000", width, [&](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            int from = (int)((it*width) % (n - width));
+            XArrayList<double> slice(0, 0, width);
+            for(int i=from; i < from + width; i++) slice.add(list.get(i));
+            double sum = 0;
+            for(double value: slice) sum += value;
+            do_not_optimize(sum);
+        }
+        return timer.stop();
+    });
+    harness.run("XArrayList/subList/1000", width, [&](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            int from = (int)((it*width) % (n - width));
+            XArraySpan<double> slice = list.subList(from, from + width);
+            double sum = 0;
+            for(double value: slice) sum += value;
+            do_not_optimize(sum);
+        }
+        return timer.stop();
+    });
+}
+
+//sort 1M random ints / Points by x; the copy of the unsorted list is untimed
+static void bench_sort(BenchHarness& harness){
+    const int n = 1000000;
+    XArrayList<int> ints;
+    XArrayList<Point> points;
+    unsigned int state = 12345;
+    for(int i=0; i < n; i++){
+        state = state*1664525u + 1013904223u;
+        ints.add((int)state);
+        points.add(Point((float)(state >> 8), (float)i));
+    }
+    auto run_sort = [&](string name, auto& source, auto sort_fn){
+        harness.run(name, n, [&](long iters){
+            BenchTimer timer;
+            for(long it=0; it < iters; it++){
+                auto list = source;
+                timer.start();
+                sort_fn(list);
+                timer.stop();
+                do_not_optimize(list.size());
+            }
+            return timer.elapsed();
+        });
+    };
+    run_sort("XArrayList<int>/sort/1000000", ints, [](XArrayList<int>& l){ l.sort(); });
+    run_sort("XArrayList<int>/stableSort/1000000", ints, [](XArrayList<int>& l){ l.stableSort(); });
+    run_sort("XArrayList<int>/radixSort/1000000", ints, [](XArrayList<int>& l){ l.radixSort(); });
+    run_sort("XArrayList<Point>/sort_by_x/1000000", points, [](XArrayList<Point>& l){
+        l.sort([](const Point& lhs, const Point& rhs){ return lhs.getX() < rhs.getX(); });
+    });
+    run_sort("XArrayList<Point>/radixSort_by_x/1000000", points, [](XArrayList<Point>& l){
+        l.radixSort([](const Point& p){ return p.getX(); });
+    });
+    
+    DLinkedList<int> linked;
+    for(int i=0; i < n; i++) linked.add(ints.get(i));
+    run_sort("DLinkedList<int>/sort/1000000", linked, [](DLinkedList<int>& l){ l.sort(); });
+}
+
+void bench_lists(BenchHarness& harness){
+    bench_list<XArrayList<int>>(harness, "XArrayList");
+    bench_list<DLinkedList<int>>(harness, "DLinkedList");
+    bench_list<XSmallList<int, 16>>(harness, "XSmallList<16>");
+    bench_list<PersistentList<int>>(harness, "PersistentList");
+    bench_list<XDeque<int>>(harness, "XDeque");
+    bench_growth(harness);
+    bench_tiny<XArrayList<int>>(harness, "XArrayList");
+    bench_tiny<XSmallList<int, 4>>(harness, "XSmallList<4>");
+    bench_snapshot(harness);
+    bench_fifo<XArrayList<int>>(harness, "XArrayList");
+    bench_fifo<DLinkedList<int>>(harness, "DLinkedList");
+    bench_fifo<XDeque<int>>(harness, "XDeque");
+    bench_heap<2>(harness, "XHeap<2>");
+    bench_heap<4>(harness, "XHeap<4>");
+    bench_concurrent_add(harness);
+    bench_queues(harness);
+    bench_intrusive(harness);
+    bench_slice(harness);
+    bench_sort(harness);
+}
@@ -0,0 +1,140 @@
+/*
+ * File:   bench_main.cpp
+ */
+
+#include "harness.h"
+#include "util/AllocTracker.h"
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+BenchHarness::BenchHarness(int argc, char** argv): m_dMinTime(0.2) {
+    for(int idx=1; idx < argc; idx++){
+        string arg = argv[idx];
+        if(arg.rfind("--filter=", 0) == 0) m_sFilter = arg.substr(9);
+        else if(arg.rfind("--json=", 0) == 0) m_sJson = arg.substr(7);
+        else if(arg.rfind("--min-time=", 0) == 0) m_dMinTime = atof(arg.substr(11).c_str());
+        else{
+            cerr << "usage: " << argv[0]
+                 << " [--filter=substring] [--min-time=seconds] [--json=file]" << endl;
+            exit(2);
+        }
+    }
+    cout << left << setw(48) << "benchmark" << right << setw(12) << "iterations"
+         << setw(16) << "time/iter" << setw(16) << "items/s" << setw(12) << "GFLOP/s";
+    if(AllocTracker::enabled()) cout << setw(12) << "allocs/it" << setw(14) << "bytes/it";
+    cout << endl;
+}
+
+bool BenchHarness::enabled(string name){
+    return m_sFilter.empty() || name.find(m_sFilter) != string::npos;
+}
+
+static string human_time(double ns){
+    double value = ns;
+    string unit = "ns";
+    if(ns >= 1e9){ value = ns/1e9; unit = "s"; }
+    else if(ns >= 1e6){ value = ns/1e6; unit = "ms"; }
+    else if(ns >= 1e3){ value = ns/1e3; unit = "us"; }
+    stringstream ss;
+    ss << fixed << setprecision(value < 10? 2 : (value < 100? 1 : 0)) << value << " " << unit;
+    return ss.str();
+}
+
+void BenchHarness::run(string name, double items_per_iter, std::function<double(long)> fn,
+                       double flops_per_iter){
+    if(!enabled(name)) return;
+    fn(1); //warm-up: caches, lazy allocations
+    long iters = 1;
+    double seconds = 0;
+    while(true){
+        seconds = fn(iters);
+        if(seconds >= m_dMinTime || iters >= 1000000000L) break;
+        double grow = (seconds <= 0)? 10 : 1.4*m_dMinTime/seconds;
+        grow = std::min(10.0, std::max(2.0, grow));
+        iters = static_cast<long>(iters*grow);
+    }
+    
+    BenchResult res;
+    res.name = name;
+    res.iterations = iters;
+    res.ns_per_iter = 1e9*seconds/iters;
+    res.items_per_second = (items_per_iter > 0)? items_per_iter*iters/seconds : 0;
+    res.flops_per_second = (flops_per_iter > 0)? flops_per_iter*iters/seconds : 0;
+    res.bytes_per_iter = -1;
+    res.allocs_per_iter = -1;
+    if(AllocTracker::enabled()){
+        AllocRegion region(name);
+        fn(1);
+        res.allocs_per_iter = region.total().allocations;
+        res.bytes_per_iter = region.total().bytes_allocated;
+    }
+    m_results.push_back(res);
+    
+    cout << left << setw(48) << name << right << setw(12) << iters
+         << setw(16) << human_time(res.ns_per_iter);
+    if(res.items_per_second > 0) cout << setw(16) << scientific << setprecision(3) << res.items_per_second;
+    else cout << setw(16) << "-";
+    if(res.flops_per_second > 0) cout << setw(12) << fixed << setprecision(2) << res.flops_per_second/1e9;
+    else if(res.allocs_per_iter >= 0) cout << setw(12) << "-";
+    if(res.allocs_per_iter >= 0) cout << setw(12) << fixed << setprecision(0) << res.allocs_per_iter
+                                      << setw(14) << res.bytes_per_iter;
+    cout << defaultfloat << endl;
+}
+
+void BenchHarness::counter(string name, double bytes_per_iter){
+    for(BenchResult& res: m_results)
+        if(res.name == name) res.bytes_per_iter = bytes_per_iter;
+}
+
+int BenchHarness::finish(){
+    if(m_sJson.empty()) return 0;
+    ofstream os(m_sJson);
+    if(!os.is_open()){
+        cerr << "cannot write " << m_sJson << endl;
+        return 1;
+    }
+    char date[64];
+    time_t now = time(0);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    os << setprecision(10);
+    os << "{\n  \"context\": {\n"
+       << "    \"date\": \"" << date << "\",\n"
+#ifdef __VERSION__
+       << "    \"compiler\": \"" << __VERSION__ << "\",\n"
+#endif
+#ifdef NDEBUG
+       << "    \"library_build_type\": \"release\"\n"
+#else
+       << "    \"library_build_type\": \"debug\"\n"
+#endif
+       << "  },\n  \"benchmarks\": [";
+    for(size_t idx=0; idx < m_results.size(); idx++){
+        BenchResult& res = m_results[idx];
+        os << (idx == 0? "\n" : ",\n") << "    {"
+           << "\"name\": \"" << res.name << "\", "
+           << "\"run_type\": \"iteration\", "
+           << "\"iterations\": " << res.iterations << ", "
+           << "\"real_time\": " << res.ns_per_iter << ", "
+           << "\"cpu_time\": " << res.ns_per_iter << ", "
+           << "\"time_unit\": \"ns\"";
+        if(res.items_per_second > 0) os << ", \"items_per_second\": " << res.items_per_second;
+        if(res.flops_per_second > 0) os << ", \"flops_per_second\": " << res.flops_per_second;
+        if(res.bytes_per_iter >= 0) os << ", \"bytes_per_iteration\": " << res.bytes_per_iter;
+        if(res.allocs_per_iter >= 0) os << ", \"allocs_per_iteration\": " << res.allocs_per_iter;
+        os << "}";
+    }
+    os << "\n  ]\n}\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    BenchHarness harness(argc, argv);
+    bench_lists(harness);
+    bench_map(harness);
+    bench_ann(harness);
+    return harness.finish();
+}
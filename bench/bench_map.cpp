@@ -0,0 +1,114 @@
+/*
+ * File:   bench_map.cpp
+ *
+ * XHashMap vs std::unordered_map: insert, successful and failed lookups and
+ * erase on 1M int keys, and lookups on 100K string keys.
+ */
+
+#include "harness.h"
+#include "list/XHashMap.h"
+#include <string>
+#include <unordered_map>
+
+//M is driven through put / find / remove so both maps run the same loop
+template <class M> struct map_ops;
+
+template <class K, class V>
+struct map_ops<XHashMap<K, V>> {
+    static void put(XHashMap<K, V>& map, K key, V value){ map.put(key, value); }
+    static V* find(XHashMap<K, V>& map, const K& key){ return map.find(key); }
+    static bool remove(XHashMap<K, V>& map, const K& key){ return map.remove(key); }
+};
+
+template <class K, class V>
+struct map_ops<std::unordered_map<K, V>> {
+    static void put(std::unordered_map<K, V>& map, K key, V value){ map[key] = value; }
+    static V* find(std::unordered_map<K, V>& map, const K& key){
+        auto it = map.find(key);
+        return (it == map.end())? nullptr : &it->second;
+    }
+    static bool remove(std::unordered_map<K, V>& map, const K& key){ return map.erase(key) == 1; }
+};
+
+//keys are a permutation of 0..n-1 scrambled by a multiplicative hash, so
+//neither map sees them in order
+static int scramble(int i){ return (int)((unsigned int)i*2654435761u); }
+
+template <class M>
+static void bench_int_map(BenchHarness& harness, string type){
+    typedef map_ops<M> ops;
+    const int n = 1000000;
+    harness.run(type + "/insert/1000000", n, [](long iters){
+        BenchTimer timer;
+        for(long it=0; it < iters; it++){
+            timer.start();
+            M map;
+            for(int i=0; i < n; i++) ops::put(map, scramble(i), i);
+            do_not_optimize(map.size());
+            timer.stop();
+        }
+        return timer.elapsed();
+    });
+    
+    M map;
+    for(int i=0; i < n; i++) ops::put(map, scramble(i), i);
+    harness.run(type + "/find_hit/1000000", n, [&](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            long sum = 0;
+            for(int i=0; i < n; i++) sum += *ops::find(map, scramble(i));
+            do_not_optimize(sum);
+        }
+        return timer.stop();
+    });
+    harness.run(type + "/find_miss/1000000", n, [&](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            long found = 0;
+            for(int i=n; i < 2*n; i++) found += (ops::find(map, scramble(i)) != nullptr);
+            do_not_optimize(found);
+        }
+        return timer.stop();
+    });
+    harness.run(type + "/erase/1000000", n, [&](long iters){
+        BenchTimer timer;
+        for(long it=0; it < iters; it++){
+            M copy = map;
+            timer.start();
+            long erased = 0;
+            for(int i=0; i < n; i++) erased += ops::remove(copy, scramble(i));
+            do_not_optimize(erased);
+            timer.stop();
+        }
+        return timer.elapsed();
+    });
+}
+
+template <class M>
+static void bench_string_map(BenchHarness& harness, string type){
+    typedef map_ops<M> ops;
+    const int n = 100000;
+    vector<string> keys;
+    for(int i=0; i < n; i++) keys.push_back("sample_" + to_string(scramble(i)));
+    M map;
+    for(int i=0; i < n; i++) ops::put(map, keys[i], i);
+    harness.run(type + "/find_hit_string/100000", n, [&](long iters){
+        BenchTimer timer;
+        timer.start();
+        for(long it=0; it < iters; it++){
+            long sum = 0;
+            for(int i=0; i < n; i++) sum += *ops::find(map, keys[i]);
+            do_not_optimize(sum);
+        }
+        return timer.stop();
+    });
+}
+
+void bench_map(BenchHarness& harness){
+    bench_int_map<XHashMap<int, int>>(harness, "XHashMap");
+    bench_int_map<std::unordered_map<int, int>>(harness, "std::unordered_map");
+    bench_string_map<XHashMap<string, int>>(harness, "XHashMap");
+    bench_string_map<std::unordered_map<string, int>>(harness, "std::unordered_map");
+}
@@ -0,0 +1,85 @@
+/*
+ * File:   harness.h
+ *
+ * Minimal self-contained benchmark harness for the bench executable.
+ * Each benchmark is a function that runs its operation "iters" times and
+ * returns the seconds it measured itself, so setup can stay out of the
+ * timed region. The harness grows "iters" until a run lasts at least
+ * --min-time seconds and reports time per iteration and items per second.
+ *
+ *   bench [--filter=substring] [--min-time=seconds] [--json=file]
+ *
+ * In an ALLOC_TRACKING build every benchmark also reports heap allocations
+ * and bytes per iteration, measured on one extra untimed iteration.
+ *
+ * The JSON file follows Google Benchmark's layout ("context", "benchmarks"
+ * with name / iterations / real_time / time_unit / items_per_second), so
+ * the usual comparison tooling can diff runs across commits.
+ */
+
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+using namespace std;
+
+class BenchTimer {
+public:
+    void start(){ m_start = std::chrono::steady_clock::now(); }
+    double stop(){
+        m_elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        return m_elapsed;
+    }
+    double elapsed(){ return m_elapsed; }
+private:
+    std::chrono::steady_clock::time_point m_start;
+    double m_elapsed = 0;
+};
+
+/* keep the compiler from discarding a value computed only for timing */
+template <class T>
+inline void do_not_optimize(T const& value){
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchResult {
+    string name;
+    long iterations;
+    double ns_per_iter;
+    double items_per_second;    //0 when the benchmark has no item count
+    double flops_per_second;    //0 when the benchmark has no FLOP count
+    double bytes_per_iter;      //extra counter, e.g. allocated bytes; < 0 if unused
+    double allocs_per_iter;     //heap allocations (ALLOC_TRACKING builds); < 0 if unused
+};
+
+class BenchHarness {
+public:
+    BenchHarness(int argc, char** argv);
+    
+    /* run(name, items, fn, flops): benchmark fn; items/flops are per iteration
+     */
+    void run(string name, double items_per_iter, std::function<double(long)> fn,
+             double flops_per_iter=0);
+    /* counter(name, bytes): attach a per-iteration byte count to the result
+     *      of the benchmark "name" (e.g. allocation totals)
+     */
+    void counter(string name, double bytes_per_iter);
+    bool enabled(string name);
+    
+    int finish();
+    
+private:
+    string m_sFilter;
+    string m_sJson;
+    double m_dMinTime;
+    vector<BenchResult> m_results;
+};
+
+//benchmark groups, one per source file
+void bench_lists(BenchHarness& harness);
+void bench_map(BenchHarness& harness);
+void bench_ann(BenchHarness& harness);
+
+#endif /* BENCH_HARNESS_H */
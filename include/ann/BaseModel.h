@@ -17,6 +17,11 @@
 #include "list/DLinkedList.h"
 #include "ann/Layer.h"
 #include "ann/dataloader.h"
+#include "ann/Profiler.h"
+#include "ann/CSRMatrix.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 class BaseModel {
 public:
@@ -26,8 +31,57 @@ public:
     virtual ~BaseModel();
     
     virtual xt::xarray<double> predict(xt::xarray<double> X);
+    /* predict(X, ctx): reentrant inference; does not modify the model
+     *   >> every thread passes its own "ctx"; the weights are shared
+     *   >> the returned reference points into "ctx" and stays valid until
+     *      the next call with the same context
+     */
+    const xt::xarray<double>& predict(const xt::xarray<double>& X, InferenceContext& ctx);
+    /* predict(X): sparse input; the first layer takes the CSR batch directly
+     *      when it is an FCLayer, otherwise X is densified first
+     */
+    xt::xarray<double> predict(const CSRMatrix& X);
+    
+    /* train()/eval(): switch every layer in/out of inference mode;
+     *      in inference mode forward caches nothing, so predict(X) may also
+     *      be called from several threads at once
+     */
+    void train();
+    void eval();
+    
+    /* save(filename): write every layer (type, shapes, weights, bias) to a
+     *      binary checkpoint (see ann/checkpoint.h)
+     *   >> throw std::runtime_error if the file cannot be written
+     *      or the model contains a layer type the format does not know
+     */
+    void save(string filename);
+    /* load(filename): map a checkpoint written by save and rebuild the model
+     *   >> FC weights are wrapped in place, nothing is parsed or copied
+     *   >> throw std::runtime_error if the file is not a valid checkpoint
+     */
+    static BaseModel* load(string filename);
+    
+    int num_layers(){ return layers.size(); }
+    Layer* get_layer(int index){ return layers.get(index); }
+    
+    /* enable_profiling(enable): start/stop per-layer profiling of predict;
+     *      stopping discards the collected statistics
+     *   >> safe while other threads are in predict: a profiler that is
+     *      switched off is kept until the model is destroyed, so a call that
+     *      already picked it up can finish recording into it
+     *   >> profiler(): the live statistics, nullptr while profiling is off
+     */
+    void enable_profiling(bool enable=true);
+    ModelProfiler* profiler(){ return m_pProfiler.load(std::memory_order_acquire); }
 protected:
     DLinkedList<Layer*> layers;
+    std::atomic<ModelProfiler*> m_pProfiler;    //predict pays one load when profiling is off
+    vector<ModelProfiler*> m_retiredProfilers;  //switched off, freed with the model
+    std::mutex m_profilingMutex;                //guards switching and m_retiredProfilers
+    
+    xt::xarray<double> predict_profiled(xt::xarray<double> X, ModelProfiler& profiler);
+    const xt::xarray<double>& predict_profiled(const xt::xarray<double>& X, InferenceContext& ctx,
+                                               ModelProfiler& profiler);
 };
 
 #endif /* MODEL_H */
@@ -0,0 +1,51 @@
+/*
+ * File:   CSRMatrix.h
+ *
+ * Compressed sparse row matrix of doubles, the sparse counterpart of a
+ * 2-D xt::xarray<double> batch. Indices are zero-based and stored as
+ * xt::blas_index_t so they can be handed to cxxblas sparse routines as is.
+ */
+
+#ifndef CSRMATRIX_H
+#define CSRMATRIX_H
+#include "ann/xtensor_lib.h"
+#include <vector>
+using namespace std;
+
+class CSRMatrix {
+public:
+    typedef xt::blas_index_t index_t;
+    
+    CSRMatrix(size_t cols=0);
+    
+    /* fromDense(X, tol): keep the entries of a 2-D X with |x| > tol
+     */
+    static CSRMatrix fromDense(const xt::xarray<double>& X, double tol=0);
+    xt::xarray<double> toDense() const;
+    
+    /* append_row(cols, values, n): add one row with n non-zeros;
+     *      column indices must be < cols()
+     */
+    void append_row(const index_t* cols, const double* values, size_t n);
+    /* append_rows(other, rows, n): copy rows[0..n) of "other" to the end of this matrix
+     */
+    void append_rows(const CSRMatrix& other, const size_t* rows, size_t n);
+    void reserve(size_t rows, size_t nnz);
+    
+    size_t rows() const { return m_rowPtr.size() - 1; }
+    size_t cols() const { return m_nCols; }
+    size_t nnz() const { return m_values.size(); }
+    xt::svector<unsigned long> shape() const { return {rows(), cols()}; }
+    
+    const double* values() const { return m_values.data(); }
+    const index_t* col_idx() const { return m_colIdx.data(); }
+    const index_t* row_ptr() const { return m_rowPtr.data(); }  //rows()+1 entries
+    
+private:
+    size_t m_nCols;
+    vector<double> m_values;
+    vector<index_t> m_colIdx;
+    vector<index_t> m_rowPtr;
+};
+
+#endif /* CSRMATRIX_H */
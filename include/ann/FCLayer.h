@@ -13,6 +13,9 @@
 #ifndef FCLAYER_H
 #define FCLAYER_H
 #include "ann/Layer.h"
+#include "ann/checkpoint.h"
+#include "ann/CSRMatrix.h"
+#include <memory>
 #include <string>
 using namespace std;
 
@@ -23,17 +26,49 @@ public:
     virtual ~FCLayer();
     
     xt::xarray<double> forward(xt::xarray<double> X);
+    void infer(const xt::xarray<double>& X, xt::xarray<double>& Y);
+    /* forward(X): sparse x dense path for CSR input (N, in_features);
+     *      cost scales with X.nnz(); nothing is cached for backward
+     */
+    xt::xarray<double> forward(const CSRMatrix& X);
+    double flop_count(const xt::xarray<double>& X);
+    /* fromPretrained(filename, use_bias): the first FC layer of a checkpoint
+     *      written by BaseModel::save, wrapped in place like BaseModel::load
+     *   >> with use_bias false a stored bias is ignored
+     *   >> throw std::runtime_error if the file is not a valid checkpoint or
+     *      has no FC layer (with a bias, when use_bias is true)
+     */
     static FCLayer* fromPretrained(string filename, bool use_bias);
+    /* fromMapped: build a layer whose weights/bias live inside "mapping"
+     *   >> no copy is made; the layer keeps "mapping" alive
+     *   >> bias may be nullptr when use_bias is false
+     */
+    static FCLayer* fromMapped(int in_features, int out_features, bool use_bias,
+                               shared_ptr<MappedFile> mapping, double* weights, double* bias);
+
+    int get_in_features(){ return m_nIn_Features; }
+    int get_out_features(){ return m_nOut_Features; }
+    bool get_use_bias(){ return m_bUse_Bias; }
+    const double* weights_data(){ return (m_pMappedW != nullptr)? m_pMappedW : m_aWeights.data(); }
+    const double* bias_data(){ return (m_pMappedB != nullptr)? m_pMappedB : m_aBias.data(); }
 
 protected:
     virtual void init_weights();
 private:
+    void affine(const xt::xarray<double>& X, xt::xarray<double>& Y); //Y = X*W^T + b
+    FCLayer(int in_features, int out_features, bool use_bias,
+            shared_ptr<MappedFile> mapping, double* weights, double* bias);
+
     int m_nIn_Features, m_nOut_Features;
     bool m_bUse_Bias;
     
     xt::xarray<double> m_aWeights; //out_features x in_features
     xt::xarray<double> m_aBias;
     
+    shared_ptr<MappedFile> m_pMapping; //set when weights come from a checkpoint
+    double* m_pMappedW; //out_features x in_features, inside m_pMapping
+    double* m_pMappedB; //out_features, inside m_pMapping
+    
     xt::xarray<double> m_aGrad_W; //be used in Assignment-2
     xt::xarray<double> m_aGrad_b; //be used in Assignment-2
     xt::xarray<double> m_aCached_X; //be used in Assignment-2
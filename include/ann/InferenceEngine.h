@@ -0,0 +1,101 @@
+/*
+ * File:   InferenceEngine.h
+ *
+ * In-process dynamic batching on top of BaseModel::predict.
+ * Callers on any thread submit one sample at a time and get a future; a
+ * single worker thread collects queued samples into a batch (up to
+ * max_batch_size, or whatever arrived before the oldest request's
+ * max_latency_us deadline), runs one predict and scatters the rows back.
+ */
+
+#ifndef INFERENCEENGINE_H
+#define INFERENCEENGINE_H
+#include "ann/xtensor_lib.h"
+#include "ann/BaseModel.h"
+#include "list/DLinkedList.h"
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+struct InferenceConfig {
+    int max_batch_size = 32;      //upper bound on samples per predict call
+    long max_latency_us = 2000;   //how long the oldest request may wait for company
+    int queue_depth = 1024;       //submit blocks (try_submit fails) beyond this
+    int latency_window = 4096;    //number of recent latencies kept for percentiles
+    vector<unsigned long> sample_shape; //shape of one sample; empty: the first accepted sample's
+};
+
+struct InferenceStats {
+    unsigned long long requests;  //completed requests
+    unsigned long long batches;   //predict calls
+    double mean_batch_size;
+    double p50_latency_us;        //submit -> result ready, over the recent window
+    double p99_latency_us;
+    int queued;                   //currently waiting
+};
+
+class InferenceEngine {
+public:
+    /* the engine does not own "model"; it must outlive the engine and must
+     * not be used by anyone else while the engine is running
+     */
+    InferenceEngine(BaseModel* model, InferenceConfig config = InferenceConfig());
+    virtual ~InferenceEngine();
+    
+    /* submit(sample): queue one sample (no batch dimension)
+     *   >> blocks while the queue holds queue_depth requests
+     *   >> throw std::invalid_argument if the sample's shape is not the
+     *      engine's sample shape, so one bad sample never fails a whole batch
+     *   >> throw std::runtime_error if the engine has been stopped
+     */
+    std::future<xt::xarray<double>> submit(xt::xarray<double> sample);
+    /* try_submit(sample, result): like submit, but return false instead of blocking
+     */
+    bool try_submit(xt::xarray<double> sample, std::future<xt::xarray<double>>& result);
+    
+    /* stop(): finish every queued request, then join the worker; idempotent
+     */
+    void stop();
+    InferenceStats stats();
+    
+private:
+    typedef std::chrono::steady_clock clock;
+    struct Request {
+        xt::xarray<double> sample;
+        std::promise<xt::xarray<double>> promise;
+        clock::time_point enqueued;
+    };
+    
+    InferenceEngine(const InferenceEngine& orig);
+    InferenceEngine& operator=(const InferenceEngine& orig);
+    
+    void check_shape(const xt::xarray<double>& sample);
+    std::future<xt::xarray<double>> enqueue(xt::xarray<double>& sample);
+    void worker_loop();
+    void run_batch(vector<Request*>& batch);
+    void record_latency(double latency_us);
+    
+    BaseModel* m_pModel;
+    InferenceConfig m_config;
+    
+    std::mutex m_mutex;
+    std::condition_variable m_cvNotEmpty;
+    std::condition_variable m_cvNotFull;
+    DLinkedList<Request*> m_queue;  //FIFO: add at tail, removeAt(0)
+    bool m_bStopping;
+    xt::svector<unsigned long> m_sampleShape; //valid once m_bHasShape
+    bool m_bHasShape;
+    std::thread m_worker;
+    
+    std::mutex m_statsMutex;
+    vector<double> m_latencies;     //ring buffer of the last latency_window samples
+    size_t m_nLatencyNext;
+    unsigned long long m_nRequests;
+    unsigned long long m_nBatches;
+};
+
+#endif /* INFERENCEENGINE_H */
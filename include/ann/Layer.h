@@ -14,9 +14,33 @@
 #define LAYER_H
 #include "ann/xtensor_lib.h"
 #include "ann/funtions.h"
+#include <atomic>
 #include <string>
+#include <vector>
 using namespace std;
 
+/* InferenceContext: per-call scratch for reentrant inference
+ *   >> owned by the caller (one per thread), never shared between threads
+ *   >> keeps one output buffer per layer position, so repeated calls with the
+ *      same batch shape reuse the same memory
+ */
+class InferenceContext {
+public:
+    /* reserve(nslots): make sure slots [0, nslots) exist; growing may move
+     *      the buffers, so call it before holding references to any of them
+     */
+    void reserve(int nslots){
+        if(nslots > (int)m_buffers.size()) m_buffers.resize(nslots);
+    }
+    xt::xarray<double>& scratch(int slot){
+        reserve(slot + 1);
+        return m_buffers[slot];
+    }
+    void clear(){ m_buffers.clear(); }
+private:
+    vector<xt::xarray<double>> m_buffers;
+};
+
 class Layer {
 public:
     Layer();
@@ -24,11 +48,27 @@ public:
     virtual ~Layer();
     
     virtual xt::xarray<double> forward(xt::xarray<double> X)=0;
+    /* infer(X, Y): stateless forward pass writing into Y
+     *   >> must not modify the layer, so any number of threads may call it
+     *      on the same layer concurrently (each with its own X and Y)
+     *   >> Y keeps its allocation when it already has the output shape
+     */
+    virtual void infer(const xt::xarray<double>& X, xt::xarray<double>& Y);
     virtual string getname(){return name; }
+    /* flop_count(X): floating-point operations forward performs on X;
+     *      0 for layers not worth counting (used only for profiling)
+     */
+    virtual double flop_count(const xt::xarray<double>& /*X*/){ return 0; }
+    
+    /* set_training(mode): in inference mode (false) forward does not cache
+     *      anything for backward, so it no longer writes to the layer either
+     */
+    virtual void set_training(bool mode){ is_training = mode; }
+    bool get_training(){ return is_training; }
 protected:
     
     bool is_training;
-    static unsigned long long layer_idx;
+    static std::atomic<unsigned long long> layer_idx;
     string name;
 private:
 };
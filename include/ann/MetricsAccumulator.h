@@ -0,0 +1,105 @@
+/*
+ * File:   MetricsAccumulator.h
+ *
+ * Streaming evaluation: a confusion matrix updated batch by batch, so a
+ * test set never has to be held in memory as whole label/prediction vectors.
+ * Above SPARSE_CONFUSION_THRESHOLD classes the counts are kept in a
+ * SparseConfusion instead of a dense K x K table.
+ */
+
+#ifndef METRICSACCUMULATOR_H
+#define METRICSACCUMULATOR_H
+#include "ann/xtensor_lib.h"
+#include "ann/dataset.h"
+#include <vector>
+using namespace std;
+
+class MetricsAccumulator {
+public:
+    MetricsAccumulator(int num_classes);
+    
+    /* update(y_true, y_pred): count one batch of class ids
+     *   >> throw std::out_of_range if a class id is >= num_classes; the
+     *      batch is then not counted at all
+     */
+    void update(const ulong_array& y_true, const ulong_array& y_pred);
+    /* update_logits(y_true, logits): predictions are argmax over the last axis
+     *      of "logits" (N x num_classes, or a single row)
+     *   >> y_true holds class ids (N), or one-hot/probability rows (N x num_classes)
+     */
+    template <typename LType>
+    void update_logits(const xt::xarray<LType>& y_true, const double_array& logits);
+    /* update(batch, logits): the batch's labels against the model output for it
+     */
+    template <typename DType, typename LType>
+    void update(Batch<DType, LType>& batch, const double_array& logits){
+        update_logits(batch.getLabel(), logits);
+    }
+    
+    /* merge(other): add the counts of another accumulator, e.g. one per thread
+     */
+    void merge(const MetricsAccumulator& other);
+    void reset();
+    
+    int num_classes(){ return m_nClasses; }
+    unsigned long long total(){ return m_nTotal; }
+    /* confusion(): dense K x K counts (materialized from the sparse form for large K)
+     */
+    ulong_array confusion();
+    SparseConfusion sparse_confusion();
+    /* metrics(): all class_metrics entries, ACCURACY .. F1_MEASURE_WEIGHTED,
+     *      computed from the counts seen so far
+     */
+    double_array metrics();
+    
+private:
+    //a batch is checked in full before any of it is counted
+    void check(ulong label, ulong pred){
+        if(label >= (ulong)m_nClasses || pred >= (ulong)m_nClasses)
+            throw std::out_of_range("MetricsAccumulator: class id is out of range!");
+    }
+    void count(ulong label, ulong pred){
+        if(m_bSparse) m_sparse.add(label, pred);
+        else m_counts[label*m_nClasses + pred] += 1;
+    }
+    static ulong argmax_row(const double* row, size_t n){
+        size_t best = 0;
+        for(size_t idx=1; idx < n; idx++) if(row[idx] > row[best]) best = idx;
+        return best;
+    }
+    
+    int m_nClasses;
+    unsigned long long m_nTotal;
+    bool m_bSparse;
+    vector<ulong> m_counts;  //dense only; row-major: true class x predicted class
+    SparseConfusion m_sparse; //sparse only
+};
+
+template <typename LType>
+void MetricsAccumulator::update_logits(const xt::xarray<LType>& y_true, const double_array& logits){
+    size_t nsamples = (logits.dimension() <= 1)? 1 : logits.shape()[0];
+    size_t ncols = (logits.dimension() == 0)? 1 : logits.shape()[logits.dimension() - 1];
+    bool one_hot = (ncols > 1 && y_true.dimension() == logits.dimension()
+                    && y_true.size() == nsamples*ncols);
+    if(!one_hot && y_true.size() != nsamples)
+        throw std::invalid_argument("MetricsAccumulator: " + to_string(y_true.size())
+                + " labels for " + to_string(nsamples) + " predictions");
+    
+    const double* plogits = logits.data();
+    const LType* plabels = y_true.data();
+    vector<double> label_row(one_hot? ncols : 0);
+    vector<ulong> labels(nsamples), preds(nsamples);
+    for(size_t idx=0; idx < nsamples; idx++){
+        preds[idx] = argmax_row(plogits + idx*ncols, ncols);
+        if(one_hot){
+            for(size_t c=0; c < ncols; c++) label_row[c] = static_cast<double>(plabels[idx*ncols + c]);
+            labels[idx] = argmax_row(label_row.data(), ncols);
+        }
+        else labels[idx] = static_cast<ulong>(plabels[idx]);
+        check(labels[idx], preds[idx]);
+    }
+    for(size_t idx=0; idx < nsamples; idx++) count(labels[idx], preds[idx]);
+    m_nTotal += nsamples;
+}
+
+#endif /* METRICSACCUMULATOR_H */
@@ -0,0 +1,59 @@
+/*
+ * File:   Profiler.h
+ *
+ * Per-layer profiling for BaseModel::predict.
+ * A BaseModel without a profiler pays one atomic pointer load per predict
+ * call; once BaseModel::enable_profiling(true) is called every
+ * forward/infer is timed and aggregated here until reset().
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+#include "ann/xtensor_lib.h"
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct LayerProfile {
+    string name;                    //Layer::getname()
+    unsigned long long calls;
+    double total_seconds;
+    double min_seconds;
+    double max_seconds;
+    string input_shape;             //shapes seen on the most recent call
+    string output_shape;
+    unsigned long long bytes_allocated;   //output buffers allocated, all calls
+    double flops;                   //floating-point operations, all calls
+    
+    double mean_ms(){ return calls == 0? 0 : 1e3*total_seconds/calls; }
+    double gflops(){ return total_seconds <= 0? 0 : flops/total_seconds/1e9; }
+};
+
+class ModelProfiler {
+public:
+    ModelProfiler();
+    
+    /* record(position, name, X, Y, seconds, bytes, flops): add one call of the
+     *      layer at "position" in the model; safe to call from several threads
+     */
+    void record(int position, string name, const xt::xarray<double>& X,
+                const xt::xarray<double>& Y, double seconds,
+                unsigned long long bytes, double flops);
+    void reset();
+    
+    vector<LayerProfile> snapshot();
+    /* toTable(): fixed-width text table, one row per layer plus a total row
+     */
+    string toTable();
+    /* toJSON(): {"layers": [{"name": ..., "calls": ..., ...}, ...]}
+     */
+    string toJSON();
+    void println(){ cout << toTable() << endl; }
+    
+private:
+    std::mutex m_mutex;
+    vector<LayerProfile> m_layers;  //indexed by layer position
+};
+
+#endif /* PROFILER_H */
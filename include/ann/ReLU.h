@@ -22,6 +22,7 @@ public:
     virtual ~ReLU();
     
     xt::xarray<double> forward(xt::xarray<double> X);
+    void infer(const xt::xarray<double>& X, xt::xarray<double>& Y);
 private:
     xt::xarray<bool> mask;
 };
@@ -21,6 +21,8 @@ public:
     virtual ~Softmax();
 
     virtual xt::xarray<double> forward(xt::xarray<double> X);
+    void infer(const xt::xarray<double>& X, xt::xarray<double>& Y);
+    int get_axis(){ return axis; }
     
 private:
     int axis;
@@ -0,0 +1,93 @@
+/*
+ * File:   checkpoint.h
+ *
+ * Versioned binary checkpoint format for BaseModel.
+ *
+ * Layout (all offsets are absolute and 64-byte aligned):
+ *
+ *   [CheckpointHeader           ]  64 bytes
+ *   [CheckpointLayerRecord x N  ]  64 bytes each, one per layer in order
+ *   [payload: weights/bias ...  ]  raw doubles, each blob 64-byte aligned
+ *
+ * A checkpoint is written by BaseModel::save and opened by BaseModel::load.
+ * Loading maps the file into memory and FCLayer wraps the payload directly
+ * (xt::adapt, no copy), so open time does not depend on model size.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+using namespace std;
+
+#define CHECKPOINT_MAGIC "XANNCKPT"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_ENDIAN_TAG 0x01020304u
+#define CHECKPOINT_ALIGNMENT 64
+
+enum checkpoint_layer_kind {
+    CKPT_LAYER_FC = 1,
+    CKPT_LAYER_RELU,
+    CKPT_LAYER_SOFTMAX
+};
+
+#define CKPT_FLAG_USE_BIAS 0x1u
+
+struct CheckpointHeader {
+    char magic[8];          // CHECKPOINT_MAGIC, not NUL-terminated
+    uint32_t version;       // CHECKPOINT_VERSION
+    uint32_t endian_tag;    // CHECKPOINT_ENDIAN_TAG in writer's byte order
+    uint32_t num_layers;
+    uint32_t reserved0;
+    uint64_t file_size;
+    uint64_t reserved[4];
+};
+
+struct CheckpointLayerRecord {
+    uint32_t kind;          // checkpoint_layer_kind
+    uint32_t flags;         // CKPT_FLAG_*
+    int32_t in_features;    // FC only
+    int32_t out_features;   // FC only
+    int32_t axis;           // Softmax only
+    uint32_t reserved0;
+    uint64_t weight_offset; // 0 if the layer has no weights
+    uint64_t bias_offset;   // 0 if the layer has no bias
+    uint64_t reserved[3];
+};
+
+static_assert(sizeof(CheckpointHeader) == CHECKPOINT_ALIGNMENT,
+              "CheckpointHeader must be exactly one alignment unit");
+static_assert(sizeof(CheckpointLayerRecord) == CHECKPOINT_ALIGNMENT,
+              "CheckpointLayerRecord must be exactly one alignment unit");
+
+inline uint64_t checkpoint_align(uint64_t offset) {
+    return (offset + CHECKPOINT_ALIGNMENT - 1) & ~uint64_t(CHECKPOINT_ALIGNMENT - 1);
+}
+
+/* MappedFile: a read-only view of a whole file mapped with mmap.
+ *   >> pages are mapped private (copy-on-write), so layers may hand out
+ *      non-const pointers without ever touching the file on disk.
+ *   >> shared by every layer that wraps part of the mapping; the mapping is
+ *      released when the last owner goes away.
+ */
+class MappedFile {
+public:
+    MappedFile(string filename);
+    ~MappedFile();
+
+    char* data(){ return m_pData; }
+    size_t size(){ return m_nSize; }
+    string filename(){ return m_sFilename; }
+
+private:
+    MappedFile(const MappedFile& orig);
+    MappedFile& operator=(const MappedFile& orig);
+
+    string m_sFilename;
+    char* m_pData;
+    size_t m_nSize;
+};
+
+#endif /* CHECKPOINT_H */
@@ -9,6 +9,7 @@
 #define DATALOADER_H
 #include "ann/xtensor_lib.h"
 #include "ann/dataset.h"
+#include "util/AllocTracker.h"
 
 using namespace std;
 
@@ -40,7 +41,8 @@ class DataLoader {
       if (seed >= 0) {
         xt::random::seed(m_seed);
       }
-      xt::random::shuffle(indices);
+      auto view = xt::adapt(indices);
+      xt::random::shuffle(view);
     }
   }
 
@@ -78,25 +80,39 @@ class DataLoader {
 
     Batch<DType, LType> operator*() const {
       size_t remaining = loader->ptr_dataset->len() - current_index;
-      size_t actual_batch_size = min(loader->batch_size, remaining);
+      size_t actual_batch_size = min((size_t)loader->batch_size, remaining);
+      ALLOC_TAG(ALLOC_DATA);
       
-      vector<size_t> batch_indices(loader->indices.begin() + current_index,
-                                   loader->indices.begin() + current_index + actual_batch_size);
-      
-      vector<xt::xarray<DType>> batch_data;
-      vector<xt::xarray<LType>> batch_labels;
-      
-      for (size_t idx : batch_indices) {
-        DataLabel<DType, LType> item = loader->ptr_dataset->getitem(idx);
-        batch_data.push_back(item.getData());
-        batch_labels.push_back(item.getLabel());
+      xt::xarray<DType> data;
+      xt::xarray<LType> labels;
+      for (size_t b = 0; b < actual_batch_size; b++) {
+        DataLabel<DType, LType> item =
+            loader->ptr_dataset->getitem(loader->indices[current_index + b]);
+        if (b == 0) {
+          data = xt::empty<DType>(batch_shape(item.getData(), actual_batch_size));
+          labels = xt::empty<LType>(batch_shape(item.getLabel(), actual_batch_size));
+        }
+        copy_into(item.getData(), data, b);
+        copy_into(item.getLabel(), labels, b);
       }
-      
-      xt::xarray<DType> data = xt::stack(batch_data);
-      xt::xarray<LType> labels = xt::stack(batch_labels);
-      
       return Batch<DType, LType>(data, labels);
     }
+
+   private:
+    //shape of a batch of n items shaped like "item"
+    template <typename T>
+    static xt::svector<unsigned long> batch_shape(const xt::xarray<T>& item, size_t n) {
+      xt::svector<unsigned long> shape = item.shape();
+      shape.insert(shape.begin(), n);
+      return shape;
+    }
+    //copy "item" into slot b of "batch" (both contiguous row-major)
+    template <typename T>
+    static void copy_into(const xt::xarray<T>& item, xt::xarray<T>& batch, size_t b) {
+      if (item.size() * batch.shape()[0] != batch.size())
+        throw std::invalid_argument("DataLoader: items in a batch differ in shape");
+      std::copy(item.data(), item.data() + item.size(), batch.data() + b * item.size());
+    }
   };
 
   Iterator begin() {
@@ -107,6 +123,93 @@ class DataLoader {
     size_t end_index = ptr_dataset->len();
     if (drop_last) {
       end_index = (end_index / batch_size) * batch_size;
+    } else if (end_index % batch_size != 0) {
+      //keep stepping by batch_size so the last partial batch ends exactly here
+      end_index = (end_index / batch_size + 1) * batch_size;
+    }
+    return Iterator(this, end_index);
+  }
+};
+
+//////////////////////////////////////////////////////////////////////
+/* SparseDataLoader: DataLoader over a SparseTensorDataset; batches stay in
+ *      CSR form (SparseBatch), so memory scales with the non-zeros
+ */
+template <typename LType>
+class SparseDataLoader {
+ private:
+  SparseTensorDataset<LType>* ptr_dataset;
+  int batch_size;
+  bool shuffle;
+  bool drop_last;
+  int m_seed;
+  vector<size_t> indices;
+
+ public:
+  SparseDataLoader(SparseTensorDataset<LType>* ptr_dataset, int batch_size,
+                   bool shuffle = true, bool drop_last = false, int seed = -1)
+      : ptr_dataset(ptr_dataset),
+        batch_size(batch_size),
+        shuffle(shuffle),
+        drop_last(drop_last),
+        m_seed(seed) {
+    indices.resize(ptr_dataset->len());
+    for (size_t i = 0; i < indices.size(); ++i) {
+      indices[i] = i;
+    }
+    if (shuffle) {
+      if (seed >= 0) {
+        xt::random::seed(m_seed);
+      }
+      auto view = xt::adapt(indices);
+      xt::random::shuffle(view);
+    }
+  }
+
+  virtual ~SparseDataLoader() = default;
+
+  class Iterator {
+   private:
+    SparseDataLoader* loader;
+    size_t current_index;
+
+   public:
+    Iterator(SparseDataLoader* loader, size_t start_index)
+        : loader(loader), current_index(start_index) {}
+
+    Iterator& operator++() {
+      current_index += loader->batch_size;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator!=(const Iterator& other) const {
+      return current_index != other.current_index;
+    }
+
+    SparseBatch<LType> operator*() const {
+      size_t remaining = loader->indices.size() - current_index;
+      size_t actual_batch_size = min((size_t)loader->batch_size, remaining);
+      ALLOC_TAG(ALLOC_DATA);
+      return loader->ptr_dataset->getbatch(loader->indices.data() + current_index,
+                                           actual_batch_size);
+    }
+  };
+
+  Iterator begin() { return Iterator(this, 0); }
+
+  Iterator end() {
+    size_t end_index = ptr_dataset->len();
+    if (drop_last) {
+      end_index = (end_index / batch_size) * batch_size;
+    } else if (end_index % batch_size != 0) {
+      //keep stepping by batch_size so the last partial batch ends exactly here
+      end_index = (end_index / batch_size + 1) * batch_size;
     }
     return Iterator(this, end_index);
   }
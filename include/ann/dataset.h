@@ -13,6 +13,7 @@
 #ifndef DATASET_H
 #define DATASET_H
 #include "ann/xtensor_lib.h"
+#include "ann/CSRMatrix.h"
 using namespace std;
 
 template <typename DType, typename LType>
@@ -102,4 +103,87 @@ class TensorDataset : public Dataset<DType, LType> {
   xt::svector<unsigned long> get_label_shape() { return label_shape; }
 };
 
+//////////////////////////////////////////////////////////////////////
+// Sparse inputs: data stays in CSR form from the dataset to FCLayer
+//////////////////////////////////////////////////////////////////////
+template <typename LType>
+class SparseBatch {
+ private:
+  CSRMatrix data;
+  xt::xarray<LType> label;
+
+ public:
+  SparseBatch(CSRMatrix data, xt::xarray<LType> label)
+      : data(std::move(data)), label(std::move(label)) {}
+  virtual ~SparseBatch() {}
+  CSRMatrix& getData() { return data; }
+  xt::xarray<LType>& getLabel() { return label; }
+};
+
+template <typename LType>
+class SparseTensorDataset : public Dataset<double, LType> {
+ private:
+  CSRMatrix data;
+  xt::xarray<LType> label;
+  xt::svector<unsigned long> data_shape, label_shape;
+
+ public:
+  SparseTensorDataset(CSRMatrix data, xt::xarray<LType> label)
+      : data(std::move(data)), label(std::move(label)) {
+    if (this->label.dimension() > 0 && this->label.shape()[0] != this->data.rows())
+      throw std::invalid_argument("SparseTensorDataset: data and label differ in length");
+    this->data_shape = this->data.shape();
+    this->label_shape = static_cast<xt::svector<unsigned long>>(this->label.shape());
+  }
+
+  int len() override { return static_cast<int>(data.rows()); }
+
+  /* getitem(index): one sample, densified; prefer getbatch for sparse flow
+   */
+  DataLabel<double, LType> getitem(int index) override {
+    if (index < 0 || index >= this->len()) {
+      throw std::out_of_range("Index is out of range!");
+    }
+    size_t row = index;
+    CSRMatrix one(data.cols());
+    one.append_rows(data, &row, 1);
+    xt::xarray<double> data_item = xt::view(one.toDense(), 0);
+    xt::xarray<LType> label_item;
+    if (label.dimension() > 0) label_item = xt::view(label, index);
+    else label_item = label;
+    return DataLabel<double, LType>(std::move(data_item), std::move(label_item));
+  }
+
+  /* getbatch(indices, n): rows indices[0..n) as a CSR batch with their labels
+   */
+  SparseBatch<LType> getbatch(const size_t* indices, size_t n) {
+    CSRMatrix rows(data.cols());
+    size_t nnz = 0;
+    for (size_t idx = 0; idx < n; idx++) {
+      if (indices[idx] >= data.rows()) throw std::out_of_range("Index is out of range!");
+      nnz += data.row_ptr()[indices[idx] + 1] - data.row_ptr()[indices[idx]];
+    }
+    rows.reserve(n, nnz);
+    rows.append_rows(data, indices, n);
+
+    xt::xarray<LType> labels;
+    if (label.dimension() > 0) {
+      xt::svector<unsigned long> shape = label_shape;
+      shape[0] = n;
+      labels = xt::empty<LType>(shape);
+      size_t stride = label.size() / label.shape()[0];
+      for (size_t idx = 0; idx < n; idx++)
+        std::copy(label.data() + indices[idx] * stride, label.data() + (indices[idx] + 1) * stride,
+                  labels.data() + idx * stride);
+    } else {
+      labels = label;
+    }
+    return SparseBatch<LType>(std::move(rows), std::move(labels));
+  }
+
+  xt::svector<unsigned long> get_data_shape() { return data_shape; }
+
+  xt::svector<unsigned long> get_label_shape() { return label_shape; }
+};
+
 #endif /* DATASET_H */
\ No newline at end of file
@@ -19,7 +19,17 @@ using namespace std;
 #include <stdexcept>
 #include "ann/xtensor_lib.h"
 
+/* softmax(X, axis): numerically stable softmax along "axis" (negative counts from the end)
+ *   >> last axis: row kernel works directly on contiguous rows
+ *   >> any other axis: the axis is swapped to the end, processed, swapped back
+ *   >> exp is a vectorizable approximation with relative error < 1e-14
+ *   >> a -inf (masked) entry gets probability exactly 0
+ */
 xt::xarray<double> softmax(xt::xarray<double> X, int axis=-1);
+/* softmax_into(X, Y, axis): same as softmax, result written into Y
+ *   >> Y keeps its allocation when it already has the shape of X
+ */
+void softmax_into(const xt::xarray<double>& X, xt::xarray<double>& Y, int axis=-1);
 
 #endif /* FUNTIONS_H */
 
@@ -26,6 +26,7 @@ using namespace std;
 #include "xtensor/xsort.hpp"
 #include "xtensor/xarray.hpp"
 #include <ctime>
+#include <unordered_map>
 
 typedef unsigned long ulong;
 typedef xt::xarray<ulong> ulong_array;
@@ -44,13 +45,72 @@ enum class_metrics{
 
 string shape2str(xt::svector<unsigned long> vec);
 int positive_index(int idx, int size);
+/* outer_stack(X, Y): X (N, A), Y (N, B) -> (N, A, B), one outer product per row
+ */
 xt::xarray<double> outer_stack(xt::xarray<double> X, xt::xarray<double>  Y);
+/* diag_stack(X): X (N, D) -> (N, D, D), one diagonal matrix per row
+ */
 xt::xarray<double> diag_stack(xt::xarray<double> X);
+/* matmul_on_stack(X, Y): strided-batched product, one GEMM per batch entry
+ *   >> X (N, A, B), Y (N, B)    -> (N, A)
+ *   >> X (N, A, B), Y (N, B, C) -> (N, A, C)
+ */
 xt::xarray<double> matmul_on_stack(xt::xarray<double> X, xt::xarray<double>  Y);
+/* softmax_jacobian_dot(Y, DY): matmul_on_stack(diag_stack(Y) - outer_stack(Y, Y), DY)
+ *      for softmax outputs Y (N, D), without building the (N, D, D) Jacobians:
+ *      row-wise y * (dy - <y, dy>), O(N*D) time and no temporaries
+ */
+xt::xarray<double> softmax_jacobian_dot(xt::xarray<double> Y, xt::xarray<double> DY);
 
-xt::xarray<ulong> confusion_matrix(xt::xarray<ulong> y_true, xt::xarray<ulong> y_pred);
+/* SparseConfusion: confusion matrix storing only non-zero cells (hash of
+ *      true*K + pred -> count); memory grows with the distinct (true, pred)
+ *      pairs seen instead of K*K. Used automatically when K is large.
+ */
+class SparseConfusion {
+public:
+    SparseConfusion(ulong nclasses=0): m_nClasses(nclasses) {}
+    
+    void add(ulong label, ulong pred, ulong n=1){
+        m_cells[(unsigned long long)label*m_nClasses + pred] += n;
+    }
+    void merge(const SparseConfusion& other);
+    ulong get(ulong label, ulong pred) const;
+    ulong nclasses() const { return m_nClasses; }
+    size_t nnz() const { return m_cells.size(); }
+    const unordered_map<unsigned long long, ulong>& cells() const { return m_cells; }
+    ulong_array to_dense() const;
+    
+private:
+    ulong m_nClasses;
+    unordered_map<unsigned long long, ulong> m_cells;
+};
+
+//number of classes above which calc_metrics(y_true, y_pred) goes through SparseConfusion
+#define SPARSE_CONFUSION_THRESHOLD 2048
+
+/* confusion_matrix(y_true, y_pred, class_counts, nthreads): dense (K x K) counts
+ *   >> large inputs are split across threads, each counting into a private
+ *      histogram; the histograms are summed at the end
+ *   >> when K x K private histograms would exceed their memory budget, each
+ *      thread instead owns a band of rows (true classes) of the result
+ *   >> class_counts, if given, receives the row sums (samples per true
+ *      class), tallied in the same pass
+ *   >> nthreads <= 0 picks the number of threads from the input size
+ */
+xt::xarray<ulong> confusion_matrix(xt::xarray<ulong> y_true, xt::xarray<ulong> y_pred,
+                                   xt::xarray<ulong>* class_counts=nullptr, int nthreads=0);
+SparseConfusion confusion_matrix_sparse(ulong_array y_true, ulong_array y_pred);
+/* class_count(confusion): row sums of a dense confusion matrix, one pass
+ *      over its K x K cells; confusion_matrix can return them for free
+ */
 xt::xarray<ulong> class_count(xt::xarray<ulong> confusion);
+xt::xarray<ulong> class_count(const SparseConfusion& confusion);
 double_array calc_metrics(ulong_array y_true, ulong_array y_pred);
+/* calc_metrics(confusion): every class_metrics entry from a (K x K)
+ *      confusion matrix (rows: true class, columns: predicted class)
+ */
+double_array calc_metrics(ulong_array confusion);
+double_array calc_metrics(const SparseConfusion& confusion);
 
 
 #endif /* XTENSOR_LIB_H */
@@ -0,0 +1,514 @@
+/*
+ * File:   ConcurrentQueue.h
+ *
+ * Bounded FIFO queues for passing items between threads, without a lock on
+ * the fast path and without an allocation per item:
+ *   >> MPMCQueue<T>: any number of producers and consumers; a ring of cells
+ *      with per-cell sequence numbers (D. Vyukov's bounded MPMC queue), so a
+ *      push or pop is one compare-and-swap on the shared position plus one
+ *      store to the cell
+ *   >> SPSCQueue<T>: exactly one producer and one consumer thread; a ring
+ *      with a head and a tail index and no compare-and-swap at all
+ * Both have the same API:
+ *   >> tryPush / tryPop: never wait, return false if full / empty
+ *   >> push / pop: wait until there is room / an item
+ *   >> tryPushFor / tryPopFor: wait at most "timeout"
+ *   >> pushBatch / popBatch: move up to n items in one step, never wait
+ * Waiting threads spin for a short while, then sleep on a condition
+ * variable; the other side only touches the mutex when someone is asleep.
+ */
+
+#ifndef CONCURRENTQUEUE_H
+#define CONCURRENTQUEUE_H
+#include "util/AllocTracker.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+using namespace std;
+
+#define CONCURRENT_QUEUE_SPINS 64
+#define CONCURRENT_QUEUE_CACHE_LINE 64
+
+/* QueueWaiter: where threads of one side of a queue (producers waiting for
+ *      room, or consumers waiting for items) go to sleep
+ */
+class QueueWaiter {
+ public:
+  QueueWaiter() : sleepers(0) {}
+
+  /* wait(ready, deadline): return true as soon as ready() holds, false if
+   *      the deadline passes first (time_point::max(): no deadline)
+   */
+  template <class Ready>
+  bool wait(Ready ready, std::chrono::steady_clock::time_point deadline) {
+    for (int spin = 0; spin < CONCURRENT_QUEUE_SPINS; spin++) {
+      if (ready()) return true;
+      std::this_thread::yield();
+    }
+    sleepers.fetch_add(1, std::memory_order_seq_cst);
+    // pairs with the fence in notify(): either the notifier sees sleepers > 0,
+    // or the ready() below sees its push / pop
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::unique_lock<std::mutex> lock(mutex);
+    bool result = true;
+    while (!ready()) {
+      if (deadline == std::chrono::steady_clock::time_point::max()) {
+        condition.wait(lock);
+      } else if (condition.wait_until(lock, deadline) == std::cv_status::timeout) {
+        result = ready();
+        break;
+      }
+    }
+    lock.unlock();
+    sleepers.fetch_sub(1, std::memory_order_relaxed);
+    return result;
+  }
+
+  /* notify(): wake the sleepers, if any; called after each push / pop
+   */
+  void notify() {
+    // orders the caller's position / sequence store before the sleepers load
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_relaxed) == 0) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    condition.notify_all();
+  }
+
+ private:
+  std::atomic<int> sleepers;
+  std::mutex mutex;
+  std::condition_variable condition;
+};
+
+//! ////////////////////////////////////////////////////////////////////
+//! //////////////////////         MPMCQueue         ///////////////////
+//! ////////////////////////////////////////////////////////////////////
+template <class T>
+class MPMCQueue {
+ protected:
+  struct Cell {
+    std::atomic<size_t> sequence;  // == position: free for the push at "position"
+    T item;                        // == position + 1: holds the item pushed there
+  };
+  Cell *cells;
+  size_t mask;
+  alignas(CONCURRENT_QUEUE_CACHE_LINE) std::atomic<size_t> pushPosition;
+  alignas(CONCURRENT_QUEUE_CACHE_LINE) std::atomic<size_t> popPosition;
+  alignas(CONCURRENT_QUEUE_CACHE_LINE) QueueWaiter notFull;
+  QueueWaiter notEmpty;
+
+ public:
+  /* MPMCQueue(int capacity): capacity is rounded up to a power of two
+   *   >> throw std::invalid_argument if capacity < 1
+   */
+  MPMCQueue(int capacity = 1024);
+  ~MPMCQueue();
+
+  bool tryPush(T e);
+  bool tryPop(T &out);
+  void push(T e);
+  T pop();
+  template <class Rep, class Period>
+  bool tryPushFor(T e, std::chrono::duration<Rep, Period> timeout);
+  template <class Rep, class Period>
+  bool tryPopFor(T &out, std::chrono::duration<Rep, Period> timeout);
+  /* pushBatch(T *items, int n): push items[0 .. k) for the largest k <= n
+   *      that fits right now; return k
+   * popBatch(T *out, int n): pop up to n items into out; return how many
+   *   >> both return 0 at once for n <= 0
+   */
+  int pushBatch(T *items, int n);
+  int popBatch(T *out, int n);
+
+  /* size(): number of items; only a snapshot while other threads work
+   */
+  int size();
+  bool empty() { return size() == 0; }
+  int getCapacity() { return (int)(mask + 1); }
+
+ private:
+  MPMCQueue(const MPMCQueue<T> &queue);
+  MPMCQueue<T> &operator=(const MPMCQueue<T> &queue);
+  bool canPush();
+  bool canPop();
+};
+
+template <class T>
+MPMCQueue<T>::MPMCQueue(int capacity) {
+  if (capacity < 1) {
+    throw std::invalid_argument("Queue capacity must be positive!");
+  }
+  size_t size = 2;
+  while (size < (size_t)capacity) size <<= 1;
+  {
+    ALLOC_TAG(ALLOC_OTHER);
+    cells = new Cell[size];
+  }
+  for (size_t i = 0; i < size; i++) {
+    cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  mask = size - 1;
+  pushPosition.store(0, std::memory_order_relaxed);
+  popPosition.store(0, std::memory_order_relaxed);
+}
+
+template <class T>
+MPMCQueue<T>::~MPMCQueue() {
+  delete[] cells;
+}
+
+template <class T>
+bool MPMCQueue<T>::tryPush(T e) {
+  size_t position = pushPosition.load(std::memory_order_relaxed);
+  Cell *cell;
+  while (true) {
+    cell = &cells[position & mask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)position;
+    if (diff == 0) {
+      if (pushPosition.compare_exchange_weak(position, position + 1,
+                                             std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return false;  // the cell still holds the item pushed one lap ago
+    } else {
+      position = pushPosition.load(std::memory_order_relaxed);
+    }
+  }
+  cell->item = std::move(e);
+  cell->sequence.store(position + 1, std::memory_order_release);
+  notEmpty.notify();
+  return true;
+}
+
+template <class T>
+bool MPMCQueue<T>::tryPop(T &out) {
+  size_t position = popPosition.load(std::memory_order_relaxed);
+  Cell *cell;
+  while (true) {
+    cell = &cells[position & mask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)(position + 1);
+    if (diff == 0) {
+      if (popPosition.compare_exchange_weak(position, position + 1,
+                                            std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return false;  // nothing has been pushed at "position" yet
+    } else {
+      position = popPosition.load(std::memory_order_relaxed);
+    }
+  }
+  out = std::move(cell->item);
+  cell->sequence.store(position + mask + 1, std::memory_order_release);
+  notFull.notify();
+  return true;
+}
+
+template <class T>
+void MPMCQueue<T>::push(T e) {
+  while (!tryPush(e)) {
+    notFull.wait([this]() { return canPush(); },
+                 std::chrono::steady_clock::time_point::max());
+  }
+}
+
+template <class T>
+T MPMCQueue<T>::pop() {
+  T item;
+  while (!tryPop(item)) {
+    notEmpty.wait([this]() { return canPop(); },
+                  std::chrono::steady_clock::time_point::max());
+  }
+  return item;
+}
+
+template <class T>
+template <class Rep, class Period>
+bool MPMCQueue<T>::tryPushFor(T e, std::chrono::duration<Rep, Period> timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!tryPush(e)) {
+    if (!notFull.wait([this]() { return canPush(); }, deadline)) return false;
+  }
+  return true;
+}
+
+template <class T>
+template <class Rep, class Period>
+bool MPMCQueue<T>::tryPopFor(T &out, std::chrono::duration<Rep, Period> timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!tryPop(out)) {
+    if (!notEmpty.wait([this]() { return canPop(); }, deadline)) return false;
+  }
+  return true;
+}
+
+template <class T>
+int MPMCQueue<T>::pushBatch(T *items, int n) {
+  if (n <= 0) return 0;
+  size_t position = pushPosition.load(std::memory_order_relaxed);
+  size_t count;
+  while (true) {
+    // claim the run of free cells starting at "position" in one step; a free
+    // cell can only be taken by whoever moves pushPosition past it
+    count = 0;
+    while (count < (size_t)n &&
+           cells[(position + count) & mask].sequence.load(std::memory_order_acquire) ==
+               position + count)
+      count++;
+    if (count == 0) {
+      size_t sequence = cells[position & mask].sequence.load(std::memory_order_acquire);
+      if ((ptrdiff_t)sequence - (ptrdiff_t)position < 0) return 0;
+      position = pushPosition.load(std::memory_order_relaxed);
+      continue;
+    }
+    if (pushPosition.compare_exchange_weak(position, position + count,
+                                           std::memory_order_relaxed))
+      break;
+  }
+  for (size_t i = 0; i < count; i++) {
+    Cell &cell = cells[(position + i) & mask];
+    cell.item = std::move(items[i]);
+    cell.sequence.store(position + i + 1, std::memory_order_release);
+  }
+  notEmpty.notify();
+  return (int)count;
+}
+
+template <class T>
+int MPMCQueue<T>::popBatch(T *out, int n) {
+  if (n <= 0) return 0;
+  size_t position = popPosition.load(std::memory_order_relaxed);
+  size_t count;
+  while (true) {
+    count = 0;
+    while (count < (size_t)n &&
+           cells[(position + count) & mask].sequence.load(std::memory_order_acquire) ==
+               position + count + 1)
+      count++;
+    if (count == 0) {
+      size_t sequence = cells[position & mask].sequence.load(std::memory_order_acquire);
+      if ((ptrdiff_t)sequence - (ptrdiff_t)(position + 1) < 0) return 0;
+      position = popPosition.load(std::memory_order_relaxed);
+      continue;
+    }
+    if (popPosition.compare_exchange_weak(position, position + count,
+                                          std::memory_order_relaxed))
+      break;
+  }
+  for (size_t i = 0; i < count; i++) {
+    Cell &cell = cells[(position + i) & mask];
+    out[i] = std::move(cell.item);
+    cell.sequence.store(position + i + mask + 1, std::memory_order_release);
+  }
+  notFull.notify();
+  return (int)count;
+}
+
+template <class T>
+int MPMCQueue<T>::size() {
+  size_t popped = popPosition.load(std::memory_order_acquire);
+  size_t pushed = pushPosition.load(std::memory_order_acquire);
+  ptrdiff_t diff = (ptrdiff_t)(pushed - popped);
+  if (diff < 0) return 0;
+  return diff > (ptrdiff_t)(mask + 1) ? (int)(mask + 1) : (int)diff;
+}
+
+template <class T>
+bool MPMCQueue<T>::canPush() {
+  size_t position = pushPosition.load(std::memory_order_relaxed);
+  size_t sequence = cells[position & mask].sequence.load(std::memory_order_acquire);
+  return (ptrdiff_t)sequence - (ptrdiff_t)position >= 0;
+}
+
+template <class T>
+bool MPMCQueue<T>::canPop() {
+  size_t position = popPosition.load(std::memory_order_relaxed);
+  size_t sequence = cells[position & mask].sequence.load(std::memory_order_acquire);
+  return (ptrdiff_t)sequence - (ptrdiff_t)(position + 1) >= 0;
+}
+
+//! ////////////////////////////////////////////////////////////////////
+//! //////////////////////         SPSCQueue         ///////////////////
+//! ////////////////////////////////////////////////////////////////////
+template <class T>
+class SPSCQueue {
+ protected:
+  T *items;
+  size_t mask;
+  // each side keeps a private copy of the other side's index and only
+  // reloads the shared one when the copy says full / empty
+  alignas(CONCURRENT_QUEUE_CACHE_LINE) std::atomic<size_t> tail;  // next push
+  size_t headCache;
+  alignas(CONCURRENT_QUEUE_CACHE_LINE) std::atomic<size_t> head;  // next pop
+  size_t tailCache;
+  alignas(CONCURRENT_QUEUE_CACHE_LINE) QueueWaiter notFull;
+  QueueWaiter notEmpty;
+
+ public:
+  /* SPSCQueue(int capacity): capacity is rounded up to a power of two
+   *   >> throw std::invalid_argument if capacity < 1
+   */
+  SPSCQueue(int capacity = 1024);
+  ~SPSCQueue();
+
+  // producer thread only
+  bool tryPush(T e);
+  void push(T e);
+  template <class Rep, class Period>
+  bool tryPushFor(T e, std::chrono::duration<Rep, Period> timeout);
+  int pushBatch(T *items, int n);
+
+  // consumer thread only
+  bool tryPop(T &out);
+  T pop();
+  template <class Rep, class Period>
+  bool tryPopFor(T &out, std::chrono::duration<Rep, Period> timeout);
+  int popBatch(T *out, int n);
+
+  int size() {
+    size_t popped = head.load(std::memory_order_acquire);  // head first: never passes tail
+    return (int)(tail.load(std::memory_order_acquire) - popped);
+  }
+  bool empty() { return size() == 0; }
+  int getCapacity() { return (int)(mask + 1); }
+
+ private:
+  SPSCQueue(const SPSCQueue<T> &queue);
+  SPSCQueue<T> &operator=(const SPSCQueue<T> &queue);
+  size_t freeSlots(size_t position);
+  size_t readySlots(size_t position);
+};
+
+template <class T>
+SPSCQueue<T>::SPSCQueue(int capacity) {
+  if (capacity < 1) {
+    throw std::invalid_argument("Queue capacity must be positive!");
+  }
+  size_t size = 2;
+  while (size < (size_t)capacity) size <<= 1;
+  {
+    ALLOC_TAG(ALLOC_OTHER);
+    items = new T[size];
+  }
+  mask = size - 1;
+  tail.store(0, std::memory_order_relaxed);
+  head.store(0, std::memory_order_relaxed);
+  headCache = 0;
+  tailCache = 0;
+}
+
+template <class T>
+SPSCQueue<T>::~SPSCQueue() {
+  delete[] items;
+}
+
+template <class T>
+size_t SPSCQueue<T>::freeSlots(size_t position) {
+  size_t capacity = mask + 1;
+  if (position - headCache == capacity) headCache = head.load(std::memory_order_acquire);
+  return capacity - (position - headCache);
+}
+
+template <class T>
+size_t SPSCQueue<T>::readySlots(size_t position) {
+  if (tailCache == position) tailCache = tail.load(std::memory_order_acquire);
+  return tailCache - position;
+}
+
+template <class T>
+bool SPSCQueue<T>::tryPush(T e) {
+  size_t position = tail.load(std::memory_order_relaxed);
+  if (freeSlots(position) == 0) return false;
+  items[position & mask] = std::move(e);
+  tail.store(position + 1, std::memory_order_release);
+  notEmpty.notify();
+  return true;
+}
+
+template <class T>
+bool SPSCQueue<T>::tryPop(T &out) {
+  size_t position = head.load(std::memory_order_relaxed);
+  if (readySlots(position) == 0) return false;
+  out = std::move(items[position & mask]);
+  head.store(position + 1, std::memory_order_release);
+  notFull.notify();
+  return true;
+}
+
+template <class T>
+void SPSCQueue<T>::push(T e) {
+  while (!tryPush(e)) {
+    notFull.wait([this]() { return freeSlots(tail.load(std::memory_order_relaxed)) > 0; },
+                 std::chrono::steady_clock::time_point::max());
+  }
+}
+
+template <class T>
+T SPSCQueue<T>::pop() {
+  T item;
+  while (!tryPop(item)) {
+    notEmpty.wait([this]() { return readySlots(head.load(std::memory_order_relaxed)) > 0; },
+                  std::chrono::steady_clock::time_point::max());
+  }
+  return item;
+}
+
+template <class T>
+template <class Rep, class Period>
+bool SPSCQueue<T>::tryPushFor(T e, std::chrono::duration<Rep, Period> timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!tryPush(e)) {
+    bool room = notFull.wait(
+        [this]() { return freeSlots(tail.load(std::memory_order_relaxed)) > 0; }, deadline);
+    if (!room) return false;
+  }
+  return true;
+}
+
+template <class T>
+template <class Rep, class Period>
+bool SPSCQueue<T>::tryPopFor(T &out, std::chrono::duration<Rep, Period> timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!tryPop(out)) {
+    bool ready = notEmpty.wait(
+        [this]() { return readySlots(head.load(std::memory_order_relaxed)) > 0; }, deadline);
+    if (!ready) return false;
+  }
+  return true;
+}
+
+template <class T>
+int SPSCQueue<T>::pushBatch(T *batch, int n) {
+  if (n <= 0) return 0;
+  size_t position = tail.load(std::memory_order_relaxed);
+  headCache = head.load(std::memory_order_acquire);
+  size_t count = freeSlots(position);
+  if (count > (size_t)n) count = n;
+  if (count == 0) return 0;
+  for (size_t i = 0; i < count; i++) items[(position + i) & mask] = std::move(batch[i]);
+  tail.store(position + count, std::memory_order_release);
+  notEmpty.notify();
+  return (int)count;
+}
+
+template <class T>
+int SPSCQueue<T>::popBatch(T *out, int n) {
+  if (n <= 0) return 0;
+  size_t position = head.load(std::memory_order_relaxed);
+  tailCache = tail.load(std::memory_order_acquire);
+  size_t count = readySlots(position);
+  if (count > (size_t)n) count = n;
+  if (count == 0) return 0;
+  for (size_t i = 0; i < count; i++) out[i] = std::move(items[(position + i) & mask]);
+  head.store(position + count, std::memory_order_release);
+  notFull.notify();
+  return (int)count;
+}
+
+#endif /* CONCURRENTQUEUE_H */
@@ -0,0 +1,322 @@
+/*
+ * File:   ConcurrentXArrayList.h
+ *
+ * ConcurrentXArrayList<T>: an append-only array list that many threads can
+ * add to and read from at the same time without a lock.
+ *   >> storage is a fixed table of blocks; block b holds FIRST << b items,
+ *      so item i lives in block floor(log2(i / FIRST + 1)). Blocks are never
+ *      moved or freed while the list is alive, so references returned by
+ *      get() stay valid across later adds
+ *   >> add() makes sure the block for the next index exists (compare-and-
+ *      swap; the loser frees its copy), claims that index with a
+ *      compare-and-swap on the size, stores the item, then publishes its
+ *      slot's state. Nothing that can throw runs between claiming and
+ *      publishing except the item's move-assignment; if that throws, the
+ *      slot is published as failed and get() on it throws instead of waiting
+ *   >> get(i) for i < size() waits until item i has been published, which
+ *      only takes as long as the adding thread needs to finish its store
+ * clear() and the destructor are not thread-safe, nor is changing an item
+ * that other threads may be reading.
+ */
+
+#ifndef CONCURRENTXARRAYLIST_H
+#define CONCURRENTXARRAYLIST_H
+#include "util/AllocTracker.h"
+#include <atomic>
+#include <climits>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+#define CONCURRENT_LIST_FIRST_BLOCK 64  // power of two
+#define CONCURRENT_LIST_MAX_BLOCKS 26   // FIRST * (2^26 - 1) > INT_MAX items
+
+template <class T>
+class ConcurrentXArrayList {
+ public:
+  class Iterator;  // forward declaration
+
+ protected:
+  enum : char { SLOT_PENDING = 0, SLOT_READY = 1, SLOT_FAILED = 2 };
+  struct Slot {
+    T item;
+    std::atomic<char> state;
+  };
+  std::atomic<Slot *> blocks[CONCURRENT_LIST_MAX_BLOCKS];
+  std::atomic<int> count;  // indices handed out, some maybe not yet ready
+  bool (*itemEqual)(T &lhs, T &rhs);
+  void (*deleteUserData)(ConcurrentXArrayList<T> *);
+
+ public:
+  ConcurrentXArrayList(void (*deleteUserData)(ConcurrentXArrayList<T> *) = 0,
+                       bool (*itemEqual)(T &, T &) = 0);
+  ~ConcurrentXArrayList();
+
+  /* add(T e): append "e"; safe to call from any number of threads
+   * return: the index of "e"
+   *   >> throw std::length_error when the list holds INT_MAX items, and
+   *      std::bad_alloc if a block cannot be allocated; the list is unchanged
+   *   >> if moving "e" into its slot throws, the index stays claimed, the
+   *      slot is marked failed and the exception is rethrown
+   */
+  int add(T e);
+  /* get(int index): return a reference to the item at "index"; safe to call
+   *      while other threads add
+   *   >> throw std::out_of_range if index >= size()
+   *   >> throw std::runtime_error if the add() of that index failed
+   */
+  T &get(int index);
+  /* isReady(int index): true if the item at "index" has been stored, i.e.
+   *      get(index) will neither wait nor throw
+   */
+  bool isReady(int index);
+  /* reserve(int n): allocate the blocks for the first "n" items up front
+   */
+  void reserve(int n);
+
+  bool empty() { return size() == 0; }
+  int size() { return count.load(std::memory_order_acquire); }
+  void clear();
+  int indexOf(T item);
+  bool contains(T item) { return indexOf(item) != -1; }
+  string toString(string (*item2str)(T &) = 0);
+
+  void println(string (*item2str)(T &) = 0) {
+    cout << toString(item2str) << endl;
+  }
+  void setDeleteUserDataPtr(void (*deleteUserData)(ConcurrentXArrayList<T> *) = 0) {
+    this->deleteUserData = deleteUserData;
+  }
+
+  /* begin() / end(): iterate over the items added before end() was called
+   */
+  Iterator begin() { return Iterator(this, 0); }
+  Iterator end() { return Iterator(this, size()); }
+
+ protected:
+  static int blockOf(int index, int &offset) {
+    unsigned long long shifted = (unsigned long long)index + CONCURRENT_LIST_FIRST_BLOCK;
+    int top = 63 - __builtin_clzll(shifted);
+    int block = top - __builtin_ctz(CONCURRENT_LIST_FIRST_BLOCK);
+    offset = (int)(shifted - (1ULL << top));
+    return block;
+  }
+  static size_t blockSize(int block) { return (size_t)CONCURRENT_LIST_FIRST_BLOCK << block; }
+  Slot *ensureBlock(int block);
+  Slot &slotAt(int index);
+  void removeInternalData();
+
+ private:
+  ConcurrentXArrayList(const ConcurrentXArrayList<T> &list);
+  ConcurrentXArrayList<T> &operator=(const ConcurrentXArrayList<T> &list);
+
+  //! FUNTION STATIC
+ protected:
+  static bool equals(T &lhs, T &rhs, bool (*itemEqual)(T &, T &)) {
+    if (itemEqual == 0)
+      return lhs == rhs;
+    else
+      return itemEqual(lhs, rhs);
+  }
+
+ public:
+  static void free(ConcurrentXArrayList<T> *list) {
+    typename ConcurrentXArrayList<T>::Iterator it = list->begin();
+    while (it != list->end()) {
+      delete *it;
+      it++;
+    }
+  }
+
+ public:
+  class Iterator {
+   private:
+    int cursor;
+    ConcurrentXArrayList<T> *pList;
+
+   public:
+    Iterator(ConcurrentXArrayList<T> *pList = 0, int index = 0) {
+      this->pList = pList;
+      this->cursor = index;
+    }
+    Iterator &operator=(const Iterator &iterator) {
+      cursor = iterator.cursor;
+      pList = iterator.pList;
+      return *this;
+    }
+
+    T &operator*() { return pList->get(cursor); }
+    bool operator!=(const Iterator &iterator) {
+      return cursor != iterator.cursor;
+    }
+    // Prefix ++ overload
+    Iterator &operator++() {
+      this->cursor++;
+      return *this;
+    }
+    // Postfix ++ overload
+    Iterator operator++(int) {
+      Iterator iterator = *this;
+      ++*this;
+      return iterator;
+    }
+  };
+};
+
+//! ////////////////////////////////////////////////////////////////////
+//! //////////////////////     METHOD DEFNITION      ///////////////////
+//! ////////////////////////////////////////////////////////////////////
+template <class T>
+ConcurrentXArrayList<T>::ConcurrentXArrayList(
+    void (*deleteUserData)(ConcurrentXArrayList<T> *), bool (*itemEqual)(T &, T &)) {
+  this->deleteUserData = deleteUserData;
+  this->itemEqual = itemEqual;
+  for (int b = 0; b < CONCURRENT_LIST_MAX_BLOCKS; b++) {
+    blocks[b].store(nullptr, std::memory_order_relaxed);
+  }
+  count.store(0, std::memory_order_relaxed);
+}
+
+template <class T>
+ConcurrentXArrayList<T>::~ConcurrentXArrayList() {
+  removeInternalData();
+}
+
+template <class T>
+int ConcurrentXArrayList<T>::add(T e) {
+  // allocate first, claim second: a throw before the claim leaves no hole
+  int index = count.load(std::memory_order_relaxed);
+  int offset;
+  Slot *block;
+  do {
+    if (index == INT_MAX) {
+      throw std::length_error("ConcurrentXArrayList is full!");
+    }
+    block = ensureBlock(blockOf(index, offset));
+  } while (!count.compare_exchange_weak(index, index + 1, std::memory_order_acq_rel,
+                                        std::memory_order_relaxed));
+  try {
+    block[offset].item = std::move(e);
+  } catch (...) {
+    block[offset].state.store(SLOT_FAILED, std::memory_order_release);
+    throw;
+  }
+  block[offset].state.store(SLOT_READY, std::memory_order_release);
+  return index;
+}
+
+template <class T>
+T &ConcurrentXArrayList<T>::get(int index) {
+  if (index < 0 || index >= size()) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  Slot &slot = slotAt(index);
+  char state;
+  while ((state = slot.state.load(std::memory_order_acquire)) == SLOT_PENDING) {
+    std::this_thread::yield();
+  }
+  if (state == SLOT_FAILED) {
+    throw std::runtime_error("Item was never stored!");
+  }
+  return slot.item;
+}
+
+template <class T>
+bool ConcurrentXArrayList<T>::isReady(int index) {
+  if (index < 0 || index >= size()) return false;
+  int offset;
+  Slot *block = blocks[blockOf(index, offset)].load(std::memory_order_acquire);
+  return block != nullptr && block[offset].state.load(std::memory_order_acquire) == SLOT_READY;
+}
+
+template <class T>
+void ConcurrentXArrayList<T>::reserve(int n) {
+  if (n <= 0) return;
+  int offset;
+  int last = blockOf(n - 1, offset);
+  for (int b = 0; b <= last; b++) ensureBlock(b);
+}
+
+template <class T>
+void ConcurrentXArrayList<T>::clear() {
+  removeInternalData();
+}
+
+template <class T>
+int ConcurrentXArrayList<T>::indexOf(T item) {
+  int n = size();
+  for (int i = 0; i < n; i++) {
+    if (equals(get(i), item, itemEqual)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+template <class T>
+string ConcurrentXArrayList<T>::toString(string (*item2str)(T &)) {
+  stringstream ss;
+  ss << "[";
+  int n = size();
+  for (int i = 0; i < n; i++) {
+    T &item = get(i);
+    if (item2str) {
+      ss << item2str(item);
+    } else if constexpr (std::is_pointer_v<T>) {
+      ss << *item;
+    } else {
+      ss << item;
+    }
+    if (i < n - 1) ss << ", ";
+  }
+  ss << "]";
+  return ss.str();
+}
+
+template <class T>
+typename ConcurrentXArrayList<T>::Slot *ConcurrentXArrayList<T>::ensureBlock(int block) {
+  Slot *current = blocks[block].load(std::memory_order_acquire);
+  if (current != nullptr) return current;
+
+  Slot *fresh;
+  {
+    ALLOC_TAG(ALLOC_XARRAYLIST);
+    fresh = new Slot[blockSize(block)]();
+  }
+  if (blocks[block].compare_exchange_strong(current, fresh, std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+    return fresh;
+  }
+  delete[] fresh;  // another thread got there first; "current" is its block
+  return current;
+}
+
+template <class T>
+typename ConcurrentXArrayList<T>::Slot &ConcurrentXArrayList<T>::slotAt(int index) {
+  // the adding thread may still be allocating the block
+  int offset;
+  int block = blockOf(index, offset);
+  Slot *storage;
+  while ((storage = blocks[block].load(std::memory_order_acquire)) == nullptr) {
+    std::this_thread::yield();
+  }
+  return storage[offset];
+}
+
+template <class T>
+void ConcurrentXArrayList<T>::removeInternalData() {
+  if (deleteUserData != nullptr) {
+    deleteUserData(this);
+  }
+  for (int b = 0; b < CONCURRENT_LIST_MAX_BLOCKS; b++) {
+    delete[] blocks[b].load(std::memory_order_relaxed);
+    blocks[b].store(nullptr, std::memory_order_relaxed);
+  }
+  count.store(0, std::memory_order_relaxed);
+}
+
+#endif /* CONCURRENTXARRAYLIST_H */
@@ -6,7 +6,10 @@
 #define DLINKEDLIST_H
 
 #include "list/IList.h"
+#include "util/AllocTracker.h"
 
+#include <atomic>
+#include <cstdlib>
 #include <sstream>
 #include <iostream>
 #include <type_traits>
@@ -18,11 +21,17 @@ class DLinkedList : public IList<T> {
   class Node;         // Forward declaration
   class Iterator;     // Forward declaration
   class BWDIterator;  // Forward declaration
+  class Cursor;       // Forward declaration
 
  protected:
   Node *head;
   Node *tail;
   int count;
+  // renewed by every change that moves or removes nodes; a Cursor taken
+  // before the change no longer matches and is ignored. Versions come from
+  // one counter shared by all lists, so a list built later at the same
+  // address never matches an old cursor either
+  unsigned long version;
   bool (*itemEqual)(T &lhs, T &rhs);
   void (*deleteUserData)(DLinkedList<T> *);
 
@@ -47,6 +56,18 @@ class DLinkedList : public IList<T> {
   string toString(string (*item2str)(T &) = 0);
   // Inherit from IList: END
 
+  /* get(int index, Cursor &cursor): like get(index), but also starts from
+   *      "cursor" when it is nearer than head or tail, and leaves it on the
+   *      returned node, so a loop over i = 0, 1, ... takes O(1) steps per call:
+   *          DLinkedList<int>::Cursor cursor;
+   *          for (int i = 0; i < list.size(); i++) sum += list.get(i, cursor);
+   *   >> get(index) itself never writes to the list, so any number of threads
+   *      may call it at once; a cursor belongs to the thread that owns it
+   *   >> a cursor of another list, or one taken before the list last moved or
+   *      removed nodes, is ignored and then re-seated
+   */
+  T &get(int index, Cursor &cursor);
+
   void println(string (*item2str)(T &) = 0) {
     cout << toString(item2str) << endl;
   }
@@ -68,10 +89,46 @@ class DLinkedList : public IList<T> {
   BWDIterator bbegin() { return BWDIterator(this, true); }
   BWDIterator bend() { return BWDIterator(this, false); }
 
+  /* splice(pos, other), splice(pos, other, first, last): move all nodes of
+   *      "other", or its nodes in [first, last), in front of "pos"
+   *   >> no node is allocated or copied; "other" may be this list, in which
+   *      case "pos" must not lie inside [first, last)
+   *   >> O(1) for a whole list or within one list; a range of another list
+   *      is O(k) for its k nodes, which are walked to keep both counts right
+   */
+  void splice(Iterator pos, DLinkedList<T> &other);
+  void splice(Iterator pos, DLinkedList<T> &other, Iterator first, Iterator last);
+  /* split(at, rest): move the nodes [at, end()) to the end of "rest"; O(k)
+   *      for the k moved nodes
+   */
+  void split(Iterator at, DLinkedList<T> &rest);
+  /* sort(), sort(comparator): stable bottom-up merge sort that relinks the
+   *      nodes in place; O(n log n) time, no allocation
+   */
+  void sort() { sort([](T &lhs, T &rhs) { return lhs < rhs; }); }
+  template <class Compare>
+  void sort(Compare comparator);
+  /* mergeSorted(other), mergeSorted(other, comparator): merge the sorted
+   *      list "other" into this sorted list in O(n + m); "other" ends up
+   *      empty, and on ties items of this list come first
+   */
+  void mergeSorted(DLinkedList<T> &other) {
+    mergeSorted(other, [](T &lhs, T &rhs) { return lhs < rhs; });
+  }
+  template <class Compare>
+  void mergeSorted(DLinkedList<T> &other, Compare comparator);
+
  protected:
   void copyFrom(const DLinkedList<T> &list);
   void removeInternalData();
-  Node *getPreviousNodeOf(int index);
+  Node *getPreviousNodeOf(int index, Cursor *cursor = nullptr);
+  void markChanged() { version = nextVersion(); }
+  static unsigned long nextVersion() {
+    static std::atomic<unsigned long> counter(0);
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+  // unlink [first, last] (inclusive, non-empty) and relink it before "pos"
+  static void transfer(Node *pos, Node *first, Node *last);
 
   //! FUNTION STATIC
  public:
@@ -114,11 +171,27 @@ class DLinkedList : public IList<T> {
     }
   };
 
+ public:
+  /* Cursor: a caller-owned position for get(index, cursor); starts empty
+   */
+  class Cursor {
+   private:
+    DLinkedList<T> *pList;
+    Node *node;
+    int index;
+    unsigned long version;
+    friend class DLinkedList<T>;
+
+   public:
+    Cursor() : pList(nullptr), node(nullptr), index(-1), version(0) {}
+  };
+
  public:
   class Iterator {
    private:
     DLinkedList<T> *pList;
     Node *pNode;
+    friend class DLinkedList<T>;
 
    public:
     Iterator(DLinkedList<T> *pList = 0, bool begin = true) {
@@ -150,6 +223,7 @@ class DLinkedList : public IList<T> {
       delete pNode;
       pNode = pPrev;
       pList->count -= 1;
+      pList->markChanged();
     }
 
     T &operator*() { return pNode->data; }
@@ -205,6 +279,7 @@ class DLinkedList : public IList<T> {
     delete pNode;
     pNode = pPrev;
     pList->count--;
+    pList->markChanged();
   }
 
   T &operator*() { return pNode->data; }
@@ -233,22 +308,26 @@ using List = DLinkedList<T>;
 template <class T>
 DLinkedList<T>::DLinkedList(void (*deleteUserData)(DLinkedList<T> *),
                             bool (*itemEqual)(T &, T &)) {
+  ALLOC_TAG(ALLOC_DLINKEDLIST);
   head = new Node();
   tail = new Node();
   head->next = tail;
   tail->prev = head;
   count = 0;
+  version = nextVersion();
   this->itemEqual = itemEqual;
   this->deleteUserData = deleteUserData;
 }
 
 template <class T>
 DLinkedList<T>::DLinkedList(const DLinkedList<T> &list) {
+  ALLOC_TAG(ALLOC_DLINKEDLIST);
   head = new Node();
   tail = new Node();
   head->next = tail;
   tail->prev = head;
   count = 0;
+  version = nextVersion();
   this->itemEqual = list.itemEqual;
   this->deleteUserData = list.deleteUserData;
   copyFrom(list);
@@ -270,6 +349,7 @@ DLinkedList<T>::~DLinkedList() {
 
 template <class T>
 void DLinkedList<T>::add(T e) {
+  ALLOC_TAG(ALLOC_DLINKEDLIST);
   Node *newNode = new Node(T(e), tail, tail->prev);
   tail->prev->next = newNode;
   tail->prev = newNode;
@@ -279,28 +359,25 @@ void DLinkedList<T>::add(T e) {
 template <class T>
 void DLinkedList<T>::add(int index, T e) {
     if (index < 0 || index > this->count) throw std::out_of_range("Index is out of range!");
-    Node *current = this->head;
-    for (int i = 0; i < index; i++) {
-        current = current->next;
-    }
+    Node *current = getPreviousNodeOf(index);
+    ALLOC_TAG(ALLOC_DLINKEDLIST);
     Node *newNode = new Node(e, current->next, current);
     current->next->prev = newNode;
     current->next = newNode;
     this->count++;
+    markChanged();
 }
 
 template <class T>
 T DLinkedList<T>::removeAt(int index) {
   if (index < 0 || index >= this->count) throw std::out_of_range("Index is out of range!");
-    Node *current = this->head->next;
-    for (int i = 0; i < index; i++) {
-        current = current->next;
-    }
+    Node *current = getPreviousNodeOf(index)->next;
     T removedData = current->data;
     current->prev->next = current->next;
     current->next->prev = current->prev;
     delete current;
     this->count--;
+    markChanged();
     return removedData;
 }
 
@@ -329,6 +406,13 @@ T &DLinkedList<T>::get(int index) {
   return node->data;
 }
 
+template <class T>
+T &DLinkedList<T>::get(int index, Cursor &cursor) {
+  if (index < 0 || index >= count) throw out_of_range("Index is out of range!");
+  Node *node = getPreviousNodeOf(index, &cursor)->next;
+  return node->data;
+}
+
 template <class T>
 int DLinkedList<T>::indexOf(T item) {
   Node *current = head->next;
@@ -349,6 +433,7 @@ bool DLinkedList<T>::removeItem(T item, void (*removeItemData)(T)) {
       if (removeItemData != nullptr) removeItemData(current->data);
       delete current;
       count--;
+      markChanged();
       return true;
     }
     current = current->next;
@@ -422,30 +507,179 @@ void DLinkedList<T>::removeInternalData() {
   head->next = tail;
   tail->prev = head;
   count = 0;
+  markChanged();
 }
 
 template <class T>
-typename DLinkedList<T>::Node *DLinkedList<T>::getPreviousNodeOf(int index) {
-  /**
-   * Returns the node preceding the specified index in the doubly linked list.
-   * If the index is in the first half of the list, it traverses from the head;
-   * otherwise, it traverses from the tail. Efficiently navigates to the node by
-   * choosing the shorter path based on the index's position.
-   */
-  // TODO implement
-  if (index <= count / 2) {
-    Node *current = head;
-    for (int i = 0; i < index; i++) {
-      current = current->next;
+void DLinkedList<T>::splice(Iterator pos, DLinkedList<T> &other) {
+  if (&other == this || other.count == 0) return;
+  transfer(pos.pNode, other.head->next, other.tail->prev);
+  count += other.count;
+  other.count = 0;
+  markChanged();
+  other.markChanged();
+}
+
+template <class T>
+void DLinkedList<T>::splice(Iterator pos, DLinkedList<T> &other, Iterator first,
+                            Iterator last) {
+  if (first.pNode == last.pNode) return;
+  if (pos.pNode == first.pNode || pos.pNode == last.pNode) return;  // in place
+  if (&other != this) {
+    int moved = 0;
+    for (Node *node = first.pNode; node != last.pNode; node = node->next) moved++;
+    count += moved;
+    other.count -= moved;
+  }
+  transfer(pos.pNode, first.pNode, last.pNode->prev);
+  markChanged();
+  other.markChanged();
+}
+
+template <class T>
+void DLinkedList<T>::split(Iterator at, DLinkedList<T> &rest) {
+  if (&rest == this || at.pNode == tail) return;
+  int moved = 0;
+  for (Node *node = at.pNode; node != tail; node = node->next) moved++;
+  transfer(rest.tail, at.pNode, tail->prev);
+  count -= moved;
+  rest.count += moved;
+  markChanged();
+}
+
+template <class T>
+template <class Compare>
+void DLinkedList<T>::sort(Compare comparator) {
+  if (count < 2) return;
+  // Bottom-up merge sort on "next" only: bins[i] holds a sorted run of 2^i
+  // nodes (or is empty); each node is pushed as a run of one and carried
+  // up like a binary counter. "prev" is rebuilt in one pass at the end.
+  auto merge = [&comparator](Node *a, Node *b) {
+    Node dummy;
+    Node *last = &dummy;
+    while (a != nullptr && b != nullptr) {
+      if (comparator(b->data, a->data)) {  // ties take a: stable
+        last->next = b;
+        b = b->next;
+      } else {
+        last->next = a;
+        a = a->next;
+      }
+      last = last->next;
     }
-    return current;
-  } else {
-    Node *current = tail;
-    for (int i = count; i > index; i--) {
-      current = current->prev;
+    last->next = (a != nullptr) ? a : b;
+    return dummy.next;
+  };
+
+  Node *bins[64] = {};
+  int nbins = 0;
+  Node *node = head->next;
+  tail->prev->next = nullptr;
+  while (node != nullptr) {
+    Node *carry = node;
+    node = node->next;
+    carry->next = nullptr;
+    int i = 0;
+    for (; i < nbins && bins[i] != nullptr; i++) {
+      carry = merge(bins[i], carry);  // bins[i] holds earlier items
+      bins[i] = nullptr;
+    }
+    bins[i] = carry;
+    if (i == nbins) nbins++;
+  }
+  Node *list = nullptr;
+  for (int i = 0; i < nbins; i++) {
+    if (bins[i] != nullptr) list = (list == nullptr) ? bins[i] : merge(bins[i], list);
+  }
+
+  Node *prev = head;
+  for (node = list; node != nullptr; node = node->next) {
+    prev->next = node;
+    node->prev = prev;
+    prev = node;
+  }
+  prev->next = tail;
+  tail->prev = prev;
+  markChanged();
+}
+
+template <class T>
+template <class Compare>
+void DLinkedList<T>::mergeSorted(DLinkedList<T> &other, Compare comparator) {
+  if (&other == this || other.count == 0) return;
+  Node *a = head->next;
+  Node *b = other.head->next;
+  while (b != other.tail) {
+    if (a == tail || comparator(b->data, a->data)) {
+      Node *next = b->next;
+      b->prev = a->prev;
+      b->next = a;
+      a->prev->next = b;
+      a->prev = b;
+      b = next;
+    } else {
+      a = a->next;
     }
-    return current;
   }
+  count += other.count;
+  other.head->next = other.tail;
+  other.tail->prev = other.head;
+  other.count = 0;
+  markChanged();
+  other.markChanged();
+}
+
+template <class T>
+void DLinkedList<T>::transfer(Node *pos, Node *first, Node *last) {
+  // unlink
+  first->prev->next = last->next;
+  last->next->prev = first->prev;
+  // link before pos
+  first->prev = pos->prev;
+  last->next = pos;
+  pos->prev->next = first;
+  pos->prev = last;
+}
+
+template <class T>
+typename DLinkedList<T>::Node *DLinkedList<T>::getPreviousNodeOf(int index, Cursor *cursor) {
+  /**
+   * Returns the node preceding the specified index in the doubly linked list
+   * (head for index 0). Starts from whichever of head, tail or the cursor
+   * (if given and still valid) is nearest, so sequential and near-sequential
+   * index loops with a cursor take O(1) steps per call. The cursor, not the
+   * list, is updated to the returned node.
+   */
+  int target = index - 1;  // position of the wanted node: head is -1, tail is count
+  Node *current = head;
+  int position = -1;
+  int distance = target + 1;
+  if (count - target < distance) {
+    current = tail;
+    position = count;
+    distance = count - target;
+  }
+  bool usable = cursor != nullptr && cursor->pList == this && cursor->version == version &&
+                cursor->index >= 0;
+  if (usable && abs(cursor->index - target) < distance) {
+    current = cursor->node;
+    position = cursor->index;
+  }
+  while (position < target) {
+    current = current->next;
+    position++;
+  }
+  while (position > target) {
+    current = current->prev;
+    position--;
+  }
+  if (cursor != nullptr && target >= 0) {
+    cursor->pList = this;
+    cursor->node = current;
+    cursor->index = target;
+    cursor->version = version;
+  }
+  return current;
 }
 
 #endif /* DLINKEDLIST_H */
\ No newline at end of file
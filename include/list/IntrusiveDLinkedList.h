@@ -0,0 +1,396 @@
+/*
+ * File:   IntrusiveDLinkedList.h
+ *
+ * IntrusiveDLinkedList<T, &T::hook>: a doubly linked list of objects the
+ * caller already owns. The links live in an IntrusiveListHook member of T,
+ * so linking an object allocates nothing and unlinking it, given the
+ * object, is O(1). An object can be in as many lists at once as it has
+ * hooks, one list per hook.
+ *
+ *     class Job {
+ *     public:
+ *       IntrusiveListHook queueHook;
+ *       ...
+ *     };
+ *     IntrusiveDLinkedList<Job, &Job::queueHook> queue;
+ *     queue.add(&job);     // no allocation
+ *     queue.remove(&job);  // O(1), no search
+ *
+ * The list never copies, owns or deletes objects (except through
+ * deleteUserData, e.g. IntrusiveDLinkedList::free). An object that is
+ * destroyed while linked unlinks itself.
+ */
+
+#ifndef INTRUSIVEDLINKEDLIST_H
+#define INTRUSIVEDLINKEDLIST_H
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+using namespace std;
+
+/* IntrusiveListHook: the links of one object in one intrusive list
+ *   >> copying an object does not copy its list membership: a copied hook
+ *      starts unlinked and assigning to a hook leaves it as it was
+ */
+class IntrusiveListHook {
+ public:
+  IntrusiveListHook() : next(nullptr), prev(nullptr), owner(nullptr), listCount(nullptr) {}
+  IntrusiveListHook(const IntrusiveListHook &)
+      : next(nullptr), prev(nullptr), owner(nullptr), listCount(nullptr) {}
+  IntrusiveListHook &operator=(const IntrusiveListHook &) { return *this; }
+  ~IntrusiveListHook() { unlink(); }
+
+  bool isLinked() const { return listCount != nullptr; }
+
+ private:
+  template <class T, IntrusiveListHook T::*Hook>
+  friend class IntrusiveDLinkedList;
+
+  void linkBefore(IntrusiveListHook *pos, void *owner, int *listCount) {
+    this->next = pos;
+    this->prev = pos->prev;
+    pos->prev->next = this;
+    pos->prev = this;
+    this->owner = owner;
+    this->listCount = listCount;
+    (*listCount)++;
+  }
+  void unlink() {
+    if (listCount == nullptr) return;
+    prev->next = next;
+    next->prev = prev;
+    (*listCount)--;
+    next = prev = nullptr;
+    owner = nullptr;
+    listCount = nullptr;
+  }
+
+  IntrusiveListHook *next;
+  IntrusiveListHook *prev;
+  void *owner;     // the object this hook is a member of
+  int *listCount;  // count of the list it is linked into; nullptr if none
+};
+
+template <class T, IntrusiveListHook T::*Hook>
+class IntrusiveDLinkedList {
+ public:
+  class Iterator;     // forward declaration
+  class BWDIterator;  // forward declaration
+
+ protected:
+  IntrusiveListHook sentinel;  // circular: sentinel.next is the first object
+  int count;
+  void (*deleteUserData)(IntrusiveDLinkedList<T, Hook> *);
+
+ public:
+  IntrusiveDLinkedList(void (*deleteUserData)(IntrusiveDLinkedList<T, Hook> *) = 0);
+  ~IntrusiveDLinkedList();
+
+  /* add(T *obj), add(int index, T *obj): link "obj" at the end / in front
+   *      of location "index"
+   *   >> throw std::invalid_argument if obj's hook is already linked
+   *   >> throw std::out_of_range if index is invalid
+   */
+  void add(T *obj);
+  void add(int index, T *obj);
+  void addFirst(T *obj);
+  /* removeAt(int index): unlink and return the object at "index"
+   *   >> throw std::out_of_range if index is invalid
+   */
+  T *removeAt(int index);
+  /* remove(T *obj): unlink "obj" in O(1)
+   * return: false if "obj" is not in this list
+   */
+  bool remove(T *obj);
+  /* removeFirst() / removeLast(): unlink and return the first / last object
+   *   >> throw std::out_of_range if the list is empty
+   */
+  T *removeFirst();
+  T *removeLast();
+
+  bool empty() { return count == 0; }
+  int size() { return count; }
+  /* clear(): unlink every object (after calling deleteUserData)
+   */
+  void clear();
+  T &get(int index);
+  T &first();
+  T &last();
+  int indexOf(T *obj);
+  /* contains(T *obj): O(1), reads obj's hook
+   */
+  bool contains(T *obj) { return (obj->*Hook).listCount == &count; }
+  string toString(string (*item2str)(T &) = 0);
+
+  void println(string (*item2str)(T &) = 0) {
+    cout << toString(item2str) << endl;
+  }
+  void setDeleteUserDataPtr(void (*deleteUserData)(IntrusiveDLinkedList<T, Hook> *) = 0) {
+    this->deleteUserData = deleteUserData;
+  }
+
+  Iterator begin() { return Iterator(this, true); }
+  Iterator end() { return Iterator(this, false); }
+
+  BWDIterator bbegin() { return BWDIterator(this, true); }
+  BWDIterator bend() { return BWDIterator(this, false); }
+
+ protected:
+  static T *objectOf(IntrusiveListHook *hook) { return static_cast<T *>(hook->owner); }
+  IntrusiveListHook *hookAt(int index);
+  void linkBefore(IntrusiveListHook *pos, T *obj);
+
+ private:
+  IntrusiveDLinkedList(const IntrusiveDLinkedList<T, Hook> &list);
+  IntrusiveDLinkedList<T, Hook> &operator=(const IntrusiveDLinkedList<T, Hook> &list);
+
+  //! FUNTION STATIC
+ public:
+  /* free: a deleteUserData that unlinks and deletes every object
+   */
+  static void free(IntrusiveDLinkedList<T, Hook> *list) {
+    while (!list->empty()) delete list->removeFirst();
+  }
+
+ public:
+  class Iterator {
+   private:
+    IntrusiveDLinkedList<T, Hook> *pList;
+    IntrusiveListHook *pHook;
+
+   public:
+    Iterator(IntrusiveDLinkedList<T, Hook> *pList = 0, bool begin = true) {
+      this->pList = pList;
+      if (pList == 0)
+        pHook = 0;
+      else
+        pHook = begin ? pList->sentinel.next : &pList->sentinel;
+    }
+    Iterator(const Iterator &iterator) : pList(iterator.pList), pHook(iterator.pHook) {}
+    Iterator &operator=(const Iterator &iterator) {
+      this->pHook = iterator.pHook;
+      this->pList = iterator.pList;
+      return *this;
+    }
+    /* remove(removeItemData): unlink the current object, then pass it to
+     *      removeItemData (e.g. to delete it); ++ moves to the next one
+     */
+    void remove(void (*removeItemData)(T *) = 0) {
+      if (!pHook || pHook == &pList->sentinel) return;
+      IntrusiveListHook *pPrev = pHook->prev;
+      T *obj = objectOf(pHook);
+      pHook->unlink();
+      if (removeItemData != 0) removeItemData(obj);
+      pHook = pPrev;
+    }
+
+    T &operator*() { return *objectOf(pHook); }
+    T *operator->() { return objectOf(pHook); }
+    bool operator!=(const Iterator &iterator) { return pHook != iterator.pHook; }
+    // Prefix ++ overload
+    Iterator &operator++() {
+      pHook = pHook->next;
+      return *this;
+    }
+    // Postfix ++ overload
+    Iterator operator++(int) {
+      Iterator iterator = *this;
+      ++*this;
+      return iterator;
+    }
+  };
+
+  class BWDIterator {
+   private:
+    IntrusiveDLinkedList<T, Hook> *pList;
+    IntrusiveListHook *pHook;
+
+   public:
+    BWDIterator(IntrusiveDLinkedList<T, Hook> *pList = 0, bool begin = true) {
+      this->pList = pList;
+      if (pList == 0)
+        pHook = 0;
+      else
+        pHook = begin ? pList->sentinel.prev : &pList->sentinel;
+    }
+    BWDIterator(const BWDIterator &iterator) : pList(iterator.pList), pHook(iterator.pHook) {}
+    BWDIterator &operator=(const BWDIterator &iterator) {
+      this->pHook = iterator.pHook;
+      this->pList = iterator.pList;
+      return *this;
+    }
+    /* remove(removeItemData): unlink the current object; -- moves to the
+     *      one before it
+     */
+    void remove(void (*removeItemData)(T *) = 0) {
+      if (!pHook || pHook == &pList->sentinel) return;
+      IntrusiveListHook *pNext = pHook->next;
+      T *obj = objectOf(pHook);
+      pHook->unlink();
+      if (removeItemData != 0) removeItemData(obj);
+      pHook = pNext;
+    }
+
+    T &operator*() { return *objectOf(pHook); }
+    T *operator->() { return objectOf(pHook); }
+    bool operator!=(const BWDIterator &iterator) { return pHook != iterator.pHook; }
+    // Prefix -- overload
+    BWDIterator &operator--() {
+      pHook = pHook->prev;
+      return *this;
+    }
+    // Postfix -- overload
+    BWDIterator operator--(int) {
+      BWDIterator iterator = *this;
+      --*this;
+      return iterator;
+    }
+  };
+};
+
+//! ////////////////////////////////////////////////////////////////////
+//! //////////////////////     METHOD DEFNITION      ///////////////////
+//! ////////////////////////////////////////////////////////////////////
+template <class T, IntrusiveListHook T::*Hook>
+IntrusiveDLinkedList<T, Hook>::IntrusiveDLinkedList(
+    void (*deleteUserData)(IntrusiveDLinkedList<T, Hook> *)) {
+  sentinel.next = &sentinel;
+  sentinel.prev = &sentinel;
+  count = 0;
+  this->deleteUserData = deleteUserData;
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+IntrusiveDLinkedList<T, Hook>::~IntrusiveDLinkedList() {
+  clear();
+  sentinel.next = sentinel.prev = nullptr;  // the sentinel itself is never linked
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+void IntrusiveDLinkedList<T, Hook>::add(T *obj) {
+  linkBefore(&sentinel, obj);
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+void IntrusiveDLinkedList<T, Hook>::addFirst(T *obj) {
+  linkBefore(sentinel.next, obj);
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+void IntrusiveDLinkedList<T, Hook>::add(int index, T *obj) {
+  if (index < 0 || index > count) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  linkBefore(index == count ? &sentinel : hookAt(index), obj);
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+T *IntrusiveDLinkedList<T, Hook>::removeAt(int index) {
+  IntrusiveListHook *hook = hookAt(index);
+  T *obj = objectOf(hook);
+  hook->unlink();
+  return obj;
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+bool IntrusiveDLinkedList<T, Hook>::remove(T *obj) {
+  if (!contains(obj)) return false;
+  (obj->*Hook).unlink();
+  return true;
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+T *IntrusiveDLinkedList<T, Hook>::removeFirst() {
+  T *obj = &first();
+  (obj->*Hook).unlink();
+  return obj;
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+T *IntrusiveDLinkedList<T, Hook>::removeLast() {
+  T *obj = &last();
+  (obj->*Hook).unlink();
+  return obj;
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+void IntrusiveDLinkedList<T, Hook>::clear() {
+  if (deleteUserData != nullptr) {
+    deleteUserData(this);
+  }
+  while (count > 0) sentinel.next->unlink();
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+T &IntrusiveDLinkedList<T, Hook>::get(int index) {
+  return *objectOf(hookAt(index));
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+T &IntrusiveDLinkedList<T, Hook>::first() {
+  if (count == 0) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  return *objectOf(sentinel.next);
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+T &IntrusiveDLinkedList<T, Hook>::last() {
+  if (count == 0) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  return *objectOf(sentinel.prev);
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+int IntrusiveDLinkedList<T, Hook>::indexOf(T *obj) {
+  if (!contains(obj)) return -1;
+  int index = 0;
+  for (IntrusiveListHook *hook = sentinel.next; hook != &(obj->*Hook); hook = hook->next) {
+    index++;
+  }
+  return index;
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+string IntrusiveDLinkedList<T, Hook>::toString(string (*item2str)(T &)) {
+  stringstream ss;
+  ss << "[";
+  for (IntrusiveListHook *hook = sentinel.next; hook != &sentinel; hook = hook->next) {
+    if (item2str)
+      ss << item2str(*objectOf(hook));
+    else
+      ss << *objectOf(hook);
+    if (hook->next != &sentinel) ss << ", ";
+  }
+  ss << "]";
+  return ss.str();
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+IntrusiveListHook *IntrusiveDLinkedList<T, Hook>::hookAt(int index) {
+  if (index < 0 || index >= count) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  IntrusiveListHook *hook;
+  if (index < count / 2) {
+    hook = sentinel.next;
+    for (int i = 0; i < index; i++) hook = hook->next;
+  } else {
+    hook = sentinel.prev;
+    for (int i = count - 1; i > index; i--) hook = hook->prev;
+  }
+  return hook;
+}
+
+template <class T, IntrusiveListHook T::*Hook>
+void IntrusiveDLinkedList<T, Hook>::linkBefore(IntrusiveListHook *pos, T *obj) {
+  IntrusiveListHook &hook = obj->*Hook;
+  if (hook.isLinked()) {
+    throw std::invalid_argument("Object is already in a list!");
+  }
+  hook.linkBefore(pos, obj, &count);
+}
+
+#endif /* INTRUSIVEDLINKEDLIST_H */
@@ -0,0 +1,189 @@
+/*
+ * File:   ListSort.h
+ *
+ * Sorting kernels over a contiguous range [data, data + n), shared by the
+ * array-backed lists (see XArrayList::sort / stableSort / radixSort).
+ *
+ *   >> list_sort:        introsort (std::sort), or list_parallel_sort for
+ *                        n >= LIST_PARALLEL_SORT_THRESHOLD
+ *   >> list_stable_sort: merge sort (std::stable_sort), parallel likewise
+ *   >> list_radix_sort:  stable LSD radix sort, 8 bits per pass, on an
+ *                        arithmetic key (the item itself, or key(item));
+ *                        passes where every key has the same byte are skipped
+ */
+
+#ifndef LISTSORT_H
+#define LISTSORT_H
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#define LIST_PARALLEL_SORT_THRESHOLD 100000
+#define LIST_PARALLEL_SORT_MIN_CHUNK 32768
+#define LIST_RADIX_SORT_MIN_SIZE 256
+
+/* radix_encode(value): map an arithmetic value to an unsigned integer of the
+ *      same width whose unsigned order is the value's order
+ *   >> signed integers: flip the sign bit
+ *   >> floating point: flip the sign bit of positives, all bits of negatives
+ *      (NaNs sort after +inf, or before -inf if their sign bit is set)
+ */
+template <class K>
+inline auto radix_encode(K value) {
+  static_assert(std::is_arithmetic<K>::value, "radix sort needs an arithmetic key");
+  if constexpr (std::is_same<K, bool>::value) {
+    return (uint8_t)value;
+  } else if constexpr (std::is_floating_point<K>::value) {
+    static_assert(sizeof(K) == 4 || sizeof(K) == 8, "unsupported floating-point key");
+    using U = typename std::conditional<sizeof(K) == 4, uint32_t, uint64_t>::type;
+    U bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const U sign = U(1) << (8 * sizeof(U) - 1);
+    return (bits & sign) ? (U)~bits : (U)(bits | sign);
+  } else if constexpr (std::is_signed<K>::value) {
+    using U = typename std::make_unsigned<K>::type;
+    return (U)((U)value ^ (U(1) << (8 * sizeof(U) - 1)));
+  } else {
+    return value;
+  }
+}
+
+/* list_comparator: lets comparators written like the lists' itemEqual,
+ *      bool (*)(T&, T&), be called on the const items the std algorithms pass
+ */
+template <class T, class Compare>
+struct list_comparator {
+  Compare cmp;
+  bool operator()(const T &lhs, const T &rhs) const {
+    return cmp(const_cast<T &>(lhs), const_cast<T &>(rhs));
+  }
+};
+
+/* list_sort_threads(n): worker count for sorting n items, 1 below the threshold
+ */
+inline int list_sort_threads(long n) {
+  if (n < LIST_PARALLEL_SORT_THRESHOLD) return 1;
+  long hw = std::thread::hardware_concurrency();
+  if (hw < 1) hw = 1;
+  long byChunk = n / LIST_PARALLEL_SORT_MIN_CHUNK;
+  return (int)std::max(1L, std::min(hw, byChunk));
+}
+
+/* list_parallel_sort(data, n, cmp, stable, nthreads): sort "nthreads" chunks
+ *      concurrently, then merge neighbouring runs pairwise, each round in
+ *      parallel, ping-ponging between "data" and one n-item buffer
+ */
+template <class T, class Compare>
+void list_parallel_sort(T *data, int n, Compare comparator, bool stable, int nthreads) {
+  list_comparator<T, Compare> cmp = {comparator};
+  if (nthreads <= 1 || n < 2) {
+    if (stable)
+      std::stable_sort(data, data + n, cmp);
+    else
+      std::sort(data, data + n, cmp);
+    return;
+  }
+  vector<int> bounds;
+  for (int w = 0; w <= nthreads; w++) bounds.push_back((int)((long)n * w / nthreads));
+
+  vector<std::thread> workers;
+  for (int w = 0; w < nthreads; w++) {
+    workers.push_back(std::thread([=]() {
+      if (stable)
+        std::stable_sort(data + bounds[w], data + bounds[w + 1], cmp);
+      else
+        std::sort(data + bounds[w], data + bounds[w + 1], cmp);
+    }));
+  }
+  for (std::thread &worker : workers) worker.join();
+
+  vector<T> buffer(n);
+  T *src = data, *dst = buffer.data();
+  while (bounds.size() > 2) {
+    vector<int> merged;
+    workers.clear();
+    size_t run = 0;
+    for (; run + 2 < bounds.size(); run += 2) {
+      int lo = bounds[run], mid = bounds[run + 1], hi = bounds[run + 2];
+      merged.push_back(lo);
+      workers.push_back(std::thread([=]() {
+        std::merge(std::make_move_iterator(src + lo), std::make_move_iterator(src + mid),
+                   std::make_move_iterator(src + mid), std::make_move_iterator(src + hi),
+                   dst + lo, cmp);
+      }));
+    }
+    if (run + 1 < bounds.size()) {  // odd run out: carry it over unchanged
+      int lo = bounds[run], hi = bounds[run + 1];
+      merged.push_back(lo);
+      std::move(src + lo, src + hi, dst + lo);
+    }
+    merged.push_back(n);
+    for (std::thread &worker : workers) worker.join();
+    bounds.swap(merged);
+    std::swap(src, dst);
+  }
+  if (src != data) std::move(src, src + n, data);
+}
+
+template <class T, class Compare>
+void list_sort(T *data, int n, Compare cmp) {
+  list_parallel_sort(data, n, cmp, false, list_sort_threads(n));
+}
+
+template <class T, class Compare>
+void list_stable_sort(T *data, int n, Compare cmp) {
+  list_parallel_sort(data, n, cmp, true, list_sort_threads(n));
+}
+
+/* list_radix_sort(data, n, key): stable sort by the arithmetic key(item)
+ */
+template <class T, class KeyFn>
+void list_radix_sort(T *data, int n, KeyFn key) {
+  if (n < LIST_RADIX_SORT_MIN_SIZE) {
+    std::stable_sort(data, data + n, [&](const T &lhs, const T &rhs) {
+      return radix_encode(key(lhs)) < radix_encode(key(rhs));
+    });
+    return;
+  }
+  using U = decltype(radix_encode(key(data[0])));
+  const int passes = sizeof(U);
+
+  // one read of the input fills the histograms of every pass
+  vector<size_t> hist(256 * passes, 0);
+  for (int i = 0; i < n; i++) {
+    U code = radix_encode(key(data[i]));
+    for (int p = 0; p < passes; p++) hist[256 * p + ((code >> (8 * p)) & 0xFF)]++;
+  }
+
+  vector<T> buffer(n);
+  T *src = data, *dst = buffer.data();
+  for (int p = 0; p < passes; p++) {
+    size_t *count = &hist[256 * p];
+    bool trivial = false;
+    for (int b = 0; b < 256; b++) {
+      if (count[b] == (size_t)n) trivial = true;
+      if (count[b] != 0) break;
+    }
+    if (trivial) continue;  // every key has the same byte here
+
+    size_t offset = 0;
+    for (int b = 0; b < 256; b++) {
+      size_t c = count[b];
+      count[b] = offset;
+      offset += c;
+    }
+    for (int i = 0; i < n; i++) {
+      U code = radix_encode(key(src[i]));
+      dst[count[(code >> (8 * p)) & 0xFF]++] = std::move(src[i]);
+    }
+    std::swap(src, dst);
+  }
+  if (src != data) std::move(src, src + n, data);
+}
+
+#endif /* LISTSORT_H */
@@ -0,0 +1,436 @@
+/*
+ * File:   PersistentList.h
+ *
+ * PersistentList<T>: an indexed list stored as a 32-way trie of shared
+ * nodes plus a "tail" leaf for appends (the layout of Clojure's vector).
+ *
+ *   >> copying a list (copy constructor, operator=, snapshot()) is O(1):
+ *      the copy shares every node with the original.
+ *   >> add(e), set(i, e), get(i) and removeAt(size()-1) are O(log32 n).
+ *      A node is copied before it is changed only if another list still
+ *      shares it, so a list that was never copied updates in place.
+ *   >> add(index, e) and removeAt(index) in the middle shift the items
+ *      after "index" and are O(n), as in XArrayList.
+ *
+ * A snapshot never sees later changes made through the list it was taken
+ * from (or the other way round). Two threads may therefore each own a list
+ * that shares nodes with the other and use it freely; a single list object
+ * still must not be used by several threads at once.
+ *
+ * The lists share the items themselves, so there is no deleteUserData:
+ * no single list can own pointed-to data that its snapshots still see.
+ */
+
+#ifndef PERSISTENTLIST_H
+#define PERSISTENTLIST_H
+#include "list/IList.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <iostream>
+#include <type_traits>
+using namespace std;
+
+template <class T>
+class PersistentList : public IList<T> {
+ public:
+  class Iterator;  // forward declaration
+
+ protected:
+  static const int BITS = 5;
+  static const int WIDTH = 1 << BITS;
+  static const int MASK = WIDTH - 1;
+
+  struct Node {};
+  struct Internal : Node {
+    shared_ptr<Node> child[WIDTH];
+  };
+  struct Leaf : Node {
+    T items[WIDTH];
+  };
+
+  shared_ptr<Node> root;  // Internal; empty while size() <= WIDTH
+  shared_ptr<Node> tail;  // Leaf holding the last 1..WIDTH items
+  int shift;              // BITS * (height of root above the leaves)
+  int count;
+  bool (*itemEqual)(T &lhs, T &rhs);
+
+ public:
+  PersistentList(bool (*itemEqual)(T &, T &) = 0);
+  PersistentList(const PersistentList<T> &list) = default;
+  PersistentList<T> &operator=(const PersistentList<T> &list) = default;
+  ~PersistentList() {}
+
+  // Inherit from IList: BEGIN
+  void add(T e);
+  void add(int index, T e);
+  T removeAt(int index);
+  bool removeItem(T item, void (*removeItemData)(T) = 0);
+  bool empty();
+  int size();
+  void clear();
+  T &get(int index);
+  int indexOf(T item);
+  bool contains(T item);
+  string toString(string (*item2str)(T &) = 0);
+  // Inherit from IList: END
+
+  void println(string (*item2str)(T &) = 0) {
+    cout << toString(item2str) << endl;
+  }
+
+  /* snapshot(): an O(1) copy that shares all nodes with this list
+   */
+  PersistentList<T> snapshot() const { return *this; }
+
+  /* at(int index): read-only access; unlike get(), never copies nodes
+   */
+  const T &at(int index) const;
+  /* set(int index, T e): replace the item at "index"
+   */
+  void set(int index, T e);
+
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, count); }
+
+ protected:
+  int tailOffset() const {
+    return count < WIDTH ? 0 : ((count - 1) >> BITS) << BITS;
+  }
+  static Internal *internal(const shared_ptr<Node> &node) {
+    return static_cast<Internal *>(node.get());
+  }
+  static Leaf *leaf(const shared_ptr<Node> &node) {
+    return static_cast<Leaf *>(node.get());
+  }
+  template <class NodeType>
+  static void makeUnique(shared_ptr<Node> &node);
+
+  const Leaf *leafFor(int index) const;
+  Leaf *editableLeafFor(int index);
+  shared_ptr<Node> newPath(int level, const shared_ptr<Node> &node);
+  void pushTail(int level, shared_ptr<Node> &node);
+  bool popTail(int level, shared_ptr<Node> &node);
+  void checkIndex(int index) const;
+
+  static bool equals(T &lhs, T &rhs, bool (*itemEqual)(T &, T &)) {
+    if (itemEqual == 0)
+      return lhs == rhs;
+    else
+      return itemEqual(lhs, rhs);
+  }
+
+ public:
+  /* Iterator: read-only, walks the list one leaf at a time
+   */
+  class Iterator {
+   private:
+    const PersistentList<T> *pList;
+    const T *pLeaf;  // items of the leaf holding "cursor"
+    int cursor;
+
+   public:
+    Iterator(const PersistentList<T> *pList = 0, int index = 0) {
+      this->pList = pList;
+      this->cursor = index;
+      this->pLeaf = 0;
+      if (pList != 0 && index < pList->count)
+        pLeaf = pList->leafFor(index)->items;
+    }
+
+    const T &operator*() { return pLeaf[cursor & MASK]; }
+    bool operator!=(const Iterator &iterator) {
+      return cursor != iterator.cursor;
+    }
+    // Prefix ++ overload
+    Iterator &operator++() {
+      cursor++;
+      if ((cursor & MASK) == 0 && cursor < pList->count)
+        pLeaf = pList->leafFor(cursor)->items;
+      return *this;
+    }
+    // Postfix ++ overload
+    Iterator operator++(int) {
+      Iterator iterator = *this;
+      ++*this;
+      return iterator;
+    }
+  };
+};
+
+//! ////////////////////////////////////////////////////////////////////
+//! //////////////////////     METHOD DEFNITION      ///////////////////
+//! ////////////////////////////////////////////////////////////////////
+template <class T>
+PersistentList<T>::PersistentList(bool (*itemEqual)(T &, T &)) {
+  this->itemEqual = itemEqual;
+  this->root = make_shared<Internal>();
+  this->tail = make_shared<Leaf>();
+  this->shift = BITS;
+  this->count = 0;
+}
+
+template <class T>
+void PersistentList<T>::add(T e) {
+  int tailCount = count - tailOffset();
+  if (tailCount < WIDTH) {
+    makeUnique<Leaf>(tail);
+    leaf(tail)->items[tailCount] = e;
+    count++;
+    return;
+  }
+  // tail is full: move it into the trie, growing a level if the trie is full
+  if ((count >> BITS) > (1 << shift)) {
+    shared_ptr<Node> newRoot = make_shared<Internal>();
+    internal(newRoot)->child[0] = root;
+    internal(newRoot)->child[1] = newPath(shift, tail);
+    root = newRoot;
+    shift += BITS;
+  } else {
+    pushTail(shift, root);
+  }
+  tail = make_shared<Leaf>();
+  leaf(tail)->items[0] = e;
+  count++;
+}
+
+template <class T>
+void PersistentList<T>::add(int index, T e) {
+  if (index < 0 || index > count) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  if (index == count) {
+    add(e);
+    return;
+  }
+  add(T(at(count - 1)));
+  // items (index, count-1) take their left neighbour, one leaf at a time
+  for (int i = count - 2; i > index;) {
+    Leaf *dst = editableLeafFor(i);
+    int first = max(index + 1, i & ~MASK);
+    for (; i >= first; i--) {
+      if ((i & MASK) != 0)
+        dst->items[i & MASK] = std::move(dst->items[(i - 1) & MASK]);
+      else
+        dst->items[0] = leafFor(i - 1)->items[MASK];
+    }
+  }
+  set(index, e);
+}
+
+template <class T>
+T PersistentList<T>::removeAt(int index) {
+  checkIndex(index);
+  T removedItem = at(index);
+  // items [index, count-1) take their right neighbour, one leaf at a time
+  for (int i = index; i < count - 1;) {
+    Leaf *dst = editableLeafFor(i);
+    int last = min(count - 2, i | MASK);
+    for (; i <= last; i++) {
+      if ((i & MASK) != MASK)
+        dst->items[i & MASK] = std::move(dst->items[(i + 1) & MASK]);
+      else
+        dst->items[MASK] = leafFor(i + 1)->items[0];
+    }
+  }
+
+  // drop the last item
+  if (count - tailOffset() > 1) {
+    makeUnique<Leaf>(tail);
+    leaf(tail)->items[count - 1 - tailOffset()] = T();
+    count--;
+    return removedItem;
+  }
+  if (count == 1) {
+    clear();
+    return removedItem;
+  }
+  // the tail becomes empty: its predecessor leaf moves out of the trie
+  shared_ptr<Node> newTail;
+  {
+    int idx = count - 2;
+    shared_ptr<Node> node = root;
+    for (int level = shift; level > 0; level -= BITS) {
+      shared_ptr<Node> next = internal(node)->child[(idx >> level) & MASK];
+      node = next;
+    }
+    newTail = node;
+  }
+  if (!popTail(shift, root)) root = make_shared<Internal>();
+  if (shift > BITS && !internal(root)->child[1]) {
+    shared_ptr<Node> only = internal(root)->child[0];
+    root = only;
+    shift -= BITS;
+  }
+  tail = newTail;
+  count--;
+  return removedItem;
+}
+
+template <class T>
+bool PersistentList<T>::removeItem(T item, void (*removeItemData)(T)) {
+  int index = indexOf(item);
+  if (index == -1) return false;
+  if (removeItemData != nullptr) removeItemData(get(index));
+  removeAt(index);
+  return true;
+}
+
+template <class T>
+bool PersistentList<T>::empty() {
+  return count == 0;
+}
+
+template <class T>
+int PersistentList<T>::size() {
+  return count;
+}
+
+template <class T>
+void PersistentList<T>::clear() {
+  root = make_shared<Internal>();
+  tail = make_shared<Leaf>();
+  shift = BITS;
+  count = 0;
+}
+
+template <class T>
+T &PersistentList<T>::get(int index) {
+  checkIndex(index);
+  return editableLeafFor(index)->items[index & MASK];
+}
+
+template <class T>
+const T &PersistentList<T>::at(int index) const {
+  checkIndex(index);
+  return leafFor(index)->items[index & MASK];
+}
+
+template <class T>
+void PersistentList<T>::set(int index, T e) {
+  checkIndex(index);
+  editableLeafFor(index)->items[index & MASK] = e;
+}
+
+template <class T>
+int PersistentList<T>::indexOf(T item) {
+  int index = 0;
+  for (Iterator it = begin(); it != end(); it++, index++) {
+    if (equals(const_cast<T &>(*it), item, itemEqual)) return index;
+  }
+  return -1;
+}
+
+template <class T>
+bool PersistentList<T>::contains(T item) {
+  return indexOf(item) != -1;
+}
+
+template <class T>
+string PersistentList<T>::toString(string (*item2str)(T &)) {
+  stringstream ss;
+  ss << "[";
+  int index = 0;
+  for (Iterator it = begin(); it != end(); it++, index++) {
+    T &item = const_cast<T &>(*it);
+    if (item2str) {
+      ss << item2str(item);
+    } else if constexpr (std::is_pointer_v<T>) {
+      ss << *item;
+    } else {
+      ss << item;
+    }
+    if (index < count - 1) ss << ", ";
+  }
+  ss << "]";
+  return ss.str();
+}
+
+//! ////////////////////////////////////////////////////////////////////
+//! ////////////////////// (private) METHOD DEFNITION //////////////////
+//! ////////////////////////////////////////////////////////////////////
+template <class T>
+template <class NodeType>
+void PersistentList<T>::makeUnique(shared_ptr<Node> &node) {
+  if (node.use_count() == 1) {
+    // the last other owner may have just let go; see its reads before writing
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return;
+  }
+  node = make_shared<NodeType>(*static_cast<NodeType *>(node.get()));
+}
+
+template <class T>
+const typename PersistentList<T>::Leaf *PersistentList<T>::leafFor(int index) const {
+  if (index >= tailOffset()) return leaf(tail);
+  const Node *node = root.get();
+  for (int level = shift; level > 0; level -= BITS) {
+    node = static_cast<const Internal *>(node)->child[(index >> level) & MASK].get();
+  }
+  return static_cast<const Leaf *>(node);
+}
+
+template <class T>
+typename PersistentList<T>::Leaf *PersistentList<T>::editableLeafFor(int index) {
+  if (index >= tailOffset()) {
+    makeUnique<Leaf>(tail);
+    return leaf(tail);
+  }
+  makeUnique<Internal>(root);
+  shared_ptr<Node> *slot = &root;
+  for (int level = shift; level > BITS; level -= BITS) {
+    slot = &internal(*slot)->child[(index >> level) & MASK];
+    makeUnique<Internal>(*slot);
+  }
+  slot = &internal(*slot)->child[(index >> BITS) & MASK];
+  makeUnique<Leaf>(*slot);
+  return leaf(*slot);
+}
+
+template <class T>
+shared_ptr<typename PersistentList<T>::Node> PersistentList<T>::newPath(
+    int level, const shared_ptr<Node> &node) {
+  if (level == 0) return node;
+  shared_ptr<Node> path = make_shared<Internal>();
+  internal(path)->child[0] = newPath(level - BITS, node);
+  return path;
+}
+
+template <class T>
+void PersistentList<T>::pushTail(int level, shared_ptr<Node> &node) {
+  makeUnique<Internal>(node);
+  shared_ptr<Node> &child = internal(node)->child[((count - 1) >> level) & MASK];
+  if (level == BITS)
+    child = tail;
+  else if (child)
+    pushTail(level - BITS, child);
+  else
+    child = newPath(level - BITS, tail);
+}
+
+template <class T>
+bool PersistentList<T>::popTail(int level, shared_ptr<Node> &node) {
+  // removes the leaf holding item count-2; false if "node" becomes empty
+  int sub = ((count - 2) >> level) & MASK;
+  if (level > BITS) {
+    makeUnique<Internal>(node);
+    shared_ptr<Node> &child = internal(node)->child[sub];
+    if (!popTail(level - BITS, child)) child.reset();
+    return sub != 0 || child;
+  }
+  if (sub == 0) return false;
+  makeUnique<Internal>(node);
+  internal(node)->child[sub].reset();
+  return true;
+}
+
+template <class T>
+void PersistentList<T>::checkIndex(int index) const {
+  if (index < 0 || index >= count) {
+    throw std::out_of_range("Index is out of range!");
+  }
+}
+
+#endif /* PERSISTENTLIST_H */
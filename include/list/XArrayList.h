@@ -5,12 +5,32 @@
 #ifndef XARRAYLIST_H
 #define XARRAYLIST_H
 #include "list/IList.h"
+#include "list/ListSort.h"
+#include "list/XArraySpan.h"
+#include "util/AllocTracker.h"
 #include <memory.h>
+#include <climits>
+#include <cstdlib>
+#include <new>
 #include <sstream>
+#include <stdexcept>
 #include <iostream>
+#include <functional>
 #include <type_traits>
+#include <utility>
 using namespace std;
 
+/* How XArrayList grows when an add() does not fit:
+ *   >> XARRAY_GROW_DOUBLE: capacity * 2 (default)
+ *   >> XARRAY_GROW_HALF:   capacity * 1.5, less slack for very large lists
+ *   >> XARRAY_GROW_CHUNK:  capacity + chunk, bounded slack, O(n) adds per chunk
+ */
+enum xarray_growth {
+  XARRAY_GROW_DOUBLE = 0,
+  XARRAY_GROW_HALF,
+  XARRAY_GROW_CHUNK
+};
+
 template <class T>
 class XArrayList : public IList<T> {
  public:
@@ -20,6 +40,9 @@ class XArrayList : public IList<T> {
   T *data;
   int capacity;
   int count;
+  int initCapacity;  // capacity given at construction, restored by clear()
+  xarray_growth growth;
+  int growthChunk;
   bool (*itemEqual)(T &lhs, T &rhs);
   void (*deleteUserData)(XArrayList<T> *);
 
@@ -51,6 +74,61 @@ class XArrayList : public IList<T> {
     this->deleteUserData = deleteUserData;
   }
 
+  /* reserve(int minCapacity): make room for at least "minCapacity" items
+   *      without reallocating; never shrinks
+   */
+  void reserve(int minCapacity);
+  /* shrink_to_fit(): release unused slots, capacity becomes size()
+   *      (at least 1)
+   */
+  void shrink_to_fit();
+  int getCapacity() { return capacity; }
+
+  /* setGrowthPolicy(policy, chunk): see xarray_growth; "chunk" is only
+   *      used by XARRAY_GROW_CHUNK and must be positive
+   */
+  void setGrowthPolicy(xarray_growth policy, int chunk = 1024);
+  xarray_growth getGrowthPolicy() { return growth; }
+
+  /* sort(), sort(comparator): in-place introsort, ascending by operator<
+   *      or by comparator(lhs, rhs) == "lhs goes first"; not stable.
+   *   >> lists of LIST_PARALLEL_SORT_THRESHOLD items or more are sorted on
+   *      several threads (see list/ListSort.h)
+   */
+  void sort() { list_sort(data, count, std::less<T>()); }
+  template <class Compare>
+  void sort(Compare comparator) { list_sort(data, count, comparator); }
+  /* stableSort(), stableSort(comparator): like sort, but equal items keep
+   *      their order
+   */
+  void stableSort() { list_stable_sort(data, count, std::less<T>()); }
+  template <class Compare>
+  void stableSort(Compare comparator) {
+    list_stable_sort(data, count, comparator);
+  }
+  /* radixSort(), radixSort(key): stable LSD radix sort, ascending by the
+   *      item itself (arithmetic T) or by an arithmetic key(item), e.g.
+   *          points.radixSort([](const Point &p) { return p.getX(); });
+   */
+  void radixSort() {
+    list_radix_sort(data, count, [](const T &item) { return item; });
+  }
+  template <class KeyFn>
+  void radixSort(KeyFn key) { list_radix_sort(data, count, key); }
+
+  /* subList(int from, int to): a view of the items [from, to), no copy;
+   *      valid until the list next reallocates (see list/XArraySpan.h)
+   *   >> throw std::out_of_range unless 0 <= from <= to <= size()
+   * asSpan(): a view of the whole list
+   */
+  XArraySpan<T> subList(int from, int to) {
+    if (from < 0 || to > count || from > to) {
+      throw std::out_of_range("Index is out of range!");
+    }
+    return XArraySpan<T>(data + from, to - from, itemEqual);
+  }
+  XArraySpan<T> asSpan() { return XArraySpan<T>(data, count, itemEqual); }
+
   Iterator begin() { return Iterator(this, 0); }
   Iterator end() { return Iterator(this, count); }
 
@@ -59,6 +137,22 @@ class XArrayList : public IList<T> {
   void ensureCapacity(int index);  // auto-allocate if needed
   void copyFrom(const XArrayList<T> &list);
   void removeInternalData();
+  void resizeStorage(int newCapacity);
+
+  /* Trivially copyable items live in malloc() storage so that growing and
+   * shrinking can use realloc(), which often extends the block in place
+   * instead of allocating, copying and freeing. Everything else uses
+   * new[]/delete[]. Define XARRAYLIST_NO_REALLOC to always use new[].
+   */
+#ifdef XARRAYLIST_NO_REALLOC
+  static constexpr bool reallocatable = false;
+#else
+  static constexpr bool reallocatable =
+      std::is_trivially_copyable<T>::value &&
+      std::is_trivially_default_constructible<T>::value;
+#endif
+  static T *allocate(int n);
+  static void release(T *ptr, int n);
 
   //! FUNTION STATIC
  protected:
@@ -127,8 +221,11 @@ XArrayList<T>::XArrayList(void (*deleteUserData)(XArrayList<T> *),
   this->deleteUserData = deleteUserData;
   this->itemEqual = itemEqual;
   this->capacity = capacity;
+  this->initCapacity = capacity;
+  this->growth = XARRAY_GROW_DOUBLE;
+  this->growthChunk = 1024;
   this->count = 0;
-  this->data = new T[capacity];
+  this->data = allocate(capacity);
 }
 
 template <class T>
@@ -208,7 +305,8 @@ template <class T>
 void XArrayList<T>::clear() {
   removeInternalData();
   count = 0;
-  data = new T[capacity];
+  capacity = initCapacity;
+  data = allocate(capacity);
 }
 
 template <class T>
@@ -262,24 +360,105 @@ void XArrayList<T>::checkIndex(int index) {
 template <class T>
 void XArrayList<T>::ensureCapacity(int minCapacity) {
   if (minCapacity > capacity) {
-    int newCapacity = max(2 * capacity, minCapacity);
-    T *newData = new T[newCapacity];
+    long long grown;
+    switch (growth) {
+      case XARRAY_GROW_HALF:
+        grown = (long long)capacity + capacity / 2;
+        break;
+      case XARRAY_GROW_CHUNK:
+        grown = (long long)capacity + growthChunk;
+        break;
+      default:
+        grown = 2LL * capacity;
+        break;
+    }
+    if (grown > INT_MAX) grown = INT_MAX;
+    resizeStorage(max((int)grown, minCapacity));
+  }
+}
+
+template <class T>
+void XArrayList<T>::reserve(int minCapacity) {
+  if (minCapacity > capacity) resizeStorage(minCapacity);
+}
+
+template <class T>
+void XArrayList<T>::shrink_to_fit() {
+  int newCapacity = max(count, 1);
+  if (newCapacity < capacity) resizeStorage(newCapacity);
+}
+
+template <class T>
+void XArrayList<T>::setGrowthPolicy(xarray_growth policy, int chunk) {
+  if (policy == XARRAY_GROW_CHUNK && chunk <= 0) {
+    throw std::invalid_argument("Growth chunk must be positive!");
+  }
+  this->growth = policy;
+  this->growthChunk = chunk;
+}
+
+template <class T>
+void XArrayList<T>::resizeStorage(int newCapacity) {
+  if constexpr (reallocatable) {
+    size_t bytes = sizeof(T) * (size_t)max(newCapacity, 1);
+    T *newData = static_cast<T *>(std::realloc(data, bytes));
+    if (newData == nullptr) throw std::bad_alloc();
+#ifdef ALLOC_TRACKING
+    AllocTracker::record_free(ALLOC_XARRAYLIST, sizeof(T) * (size_t)max(capacity, 1));
+    AllocTracker::record_alloc(ALLOC_XARRAYLIST, bytes);
+#endif
+    data = newData;
+  } else {
+    T *newData = allocate(newCapacity);
     for (int i = 0; i < count; i++) {
-      newData[i] = data[i];
+      newData[i] = std::move(data[i]);
     }
-    delete[] data;
+    release(data, capacity);
     data = newData;
-    capacity = newCapacity;
+  }
+  capacity = newCapacity;
+}
+
+template <class T>
+T *XArrayList<T>::allocate(int n) {
+  if constexpr (reallocatable) {
+    size_t bytes = sizeof(T) * (size_t)max(n, 1);
+    T *ptr = static_cast<T *>(std::malloc(bytes));
+    if (ptr == nullptr) throw std::bad_alloc();
+#ifdef ALLOC_TRACKING
+    AllocTracker::record_alloc(ALLOC_XARRAYLIST, bytes);
+#endif
+    return ptr;
+  } else {
+    ALLOC_TAG(ALLOC_XARRAYLIST);
+    return new T[n];
+  }
+}
+
+template <class T>
+void XArrayList<T>::release(T *ptr, int n) {
+  if (ptr == nullptr) return;
+  if constexpr (reallocatable) {
+#ifdef ALLOC_TRACKING
+    AllocTracker::record_free(ALLOC_XARRAYLIST, sizeof(T) * (size_t)max(n, 1));
+#endif
+    std::free(ptr);
+  } else {
+    (void)n;
+    delete[] ptr;
   }
 }
 
 template <class T>
 void XArrayList<T>::copyFrom(const XArrayList<T> &list) {
   this->capacity = list.capacity;
+  this->initCapacity = list.initCapacity;
+  this->growth = list.growth;
+  this->growthChunk = list.growthChunk;
   this->count = list.count;
   this->itemEqual = list.itemEqual;
   this->deleteUserData = list.deleteUserData;
-  this->data = new T[capacity];
+  this->data = allocate(capacity);
   for (int i = 0; i < count; i++) {
     this->data[i] = list.data[i];
   }
@@ -290,7 +469,7 @@ void XArrayList<T>::removeInternalData() {
  if (deleteUserData != nullptr) {
         deleteUserData(this);
     }
-    delete[] data;
+    release(data, capacity);
     data = nullptr;
     count = 0;
 }
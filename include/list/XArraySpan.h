@@ -0,0 +1,119 @@
+/*
+ * File:   XArraySpan.h
+ *
+ * XArraySpan<T>: a non-owning view of "size" consecutive items, usually a
+ * slice of an XArrayList (XArrayList::subList / asSpan). Making one copies
+ * two words; the items are neither copied nor freed.
+ *   >> read API of IList (get, size, empty, indexOf, contains, toString);
+ *      items can be changed in place through get() and data()
+ *   >> begin()/end() are plain pointers, so range-for and std algorithms
+ *      work, and data() can be wrapped as a tensor without a copy:
+ *          XArraySpan<double> row = list.subList(from, to);
+ *          auto x = xt::adapt(row.data(), row.size(), xt::no_ownership(),
+ *                             std::vector<size_t>{(size_t)row.size()});
+ *   >> like an iterator, a span of an XArrayList is invalidated by anything
+ *      that may reallocate the list (add, reserve, shrink_to_fit, clear, ...)
+ */
+
+#ifndef XARRAYSPAN_H
+#define XARRAYSPAN_H
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+using namespace std;
+
+template <class T>
+class XArraySpan {
+ protected:
+  T *items;
+  int count;
+  bool (*itemEqual)(T &lhs, T &rhs);
+
+ public:
+  XArraySpan(T *items = nullptr, int size = 0, bool (*itemEqual)(T &, T &) = 0) {
+    if (size < 0 || (items == nullptr && size > 0)) {
+      throw std::invalid_argument("Invalid span!");
+    }
+    this->items = items;
+    this->count = size;
+    this->itemEqual = itemEqual;
+  }
+
+  /* get(int index): return a reference to the item at location "index"
+   *   >> throw std::out_of_range if index is invalid
+   */
+  T &get(int index) {
+    if (index < 0 || index >= count) {
+      throw std::out_of_range("Index is out of range!");
+    }
+    return items[index];
+  }
+  /* operator[](int index): like get, without the range check
+   */
+  T &operator[](int index) { return items[index]; }
+  bool empty() { return count == 0; }
+  int size() { return count; }
+  int indexOf(T item);
+  bool contains(T item) { return indexOf(item) != -1; }
+  string toString(string (*item2str)(T &) = 0);
+  void println(string (*item2str)(T &) = 0) {
+    cout << toString(item2str) << endl;
+  }
+
+  /* subSpan(int from, int to): the items [from, to) of this span
+   *   >> throw std::out_of_range unless 0 <= from <= to <= size()
+   */
+  XArraySpan<T> subSpan(int from, int to) {
+    if (from < 0 || to > count || from > to) {
+      throw std::out_of_range("Index is out of range!");
+    }
+    return XArraySpan<T>(items + from, to - from, itemEqual);
+  }
+
+  T *data() { return items; }
+  T *begin() { return items; }
+  T *end() { return items + count; }
+
+ protected:
+  static bool equals(T &lhs, T &rhs, bool (*itemEqual)(T &, T &)) {
+    if (itemEqual == 0)
+      return lhs == rhs;
+    else
+      return itemEqual(lhs, rhs);
+  }
+};
+
+//! ////////////////////////////////////////////////////////////////////
+//! //////////////////////     METHOD DEFNITION      ///////////////////
+//! ////////////////////////////////////////////////////////////////////
+template <class T>
+int XArraySpan<T>::indexOf(T item) {
+  for (int i = 0; i < count; i++) {
+    if (equals(items[i], item, itemEqual)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+template <class T>
+string XArraySpan<T>::toString(string (*item2str)(T &)) {
+  stringstream ss;
+  ss << "[";
+  for (int i = 0; i < count; i++) {
+    if (item2str) {
+      ss << item2str(items[i]);
+    } else if constexpr (std::is_pointer_v<T>) {
+      ss << *items[i];
+    } else {
+      ss << items[i];
+    }
+    if (i < count - 1) ss << ", ";
+  }
+  ss << "]";
+  return ss.str();
+}
+
+#endif /* XARRAYSPAN_H */
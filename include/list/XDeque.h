@@ -0,0 +1,495 @@
+/*
+ * File:   XDeque.h
+ *
+ * XDeque<T>: a double-ended queue on a circular buffer whose capacity is
+ * always a power of two, so the slot of item i is (head + i) & (capacity - 1).
+ *   >> addFirst / addLast / removeFirst / removeLast: O(1) (amortized for add)
+ *   >> get(i): O(1), no shifting and no per-item allocation
+ *   >> add(index, e) / removeAt(index): move the shorter side, O(min(i, n - i))
+ * The items occupy at most two contiguous segments of the buffer (see
+ * firstSegment / secondSegment), which is what bulk copies should use.
+ */
+
+#ifndef XDEQUE_H
+#define XDEQUE_H
+#include "list/IList.h"
+#include "util/AllocTracker.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+#define XDEQUE_MAX_CAPACITY (1 << 30)  // largest power of two an int holds
+
+template <class T>
+class XDeque : public IList<T> {
+ public:
+  class Iterator;  // forward declaration
+
+ protected:
+  T *data;       // circular buffer of "capacity" slots
+  int capacity;  // power of two
+  int initCapacity;
+  int head;      // slot of item 0
+  int count;
+  bool (*itemEqual)(T &lhs, T &rhs);
+  void (*deleteUserData)(XDeque<T> *);
+
+ public:
+  XDeque(void (*deleteUserData)(XDeque<T> *) = 0,
+         bool (*itemEqual)(T &, T &) = 0, int capacity = 16);
+  XDeque(const XDeque<T> &list);
+  XDeque<T> &operator=(const XDeque<T> &list);
+  ~XDeque();
+
+  // Inherit from IList: BEGIN
+  void add(T e);
+  void add(int index, T e);
+  T removeAt(int index);
+  bool removeItem(T item, void (*removeItemData)(T) = 0);
+  bool empty();
+  int size();
+  void clear();
+  T &get(int index);
+  int indexOf(T item);
+  bool contains(T item);
+  string toString(string (*item2str)(T &) = 0);
+  // Inherit from IList: END
+
+  void println(string (*item2str)(T &) = 0) {
+    cout << toString(item2str) << endl;
+  }
+  void setDeleteUserDataPtr(void (*deleteUserData)(XDeque<T> *) = 0) {
+    this->deleteUserData = deleteUserData;
+  }
+
+  /* addFirst(T e) / addLast(T e): push "e" at the front / back
+   */
+  void addFirst(T e);
+  void addLast(T e) { add(e); }
+  /* removeFirst() / removeLast(): pop and return the item at the front / back
+   *   >> throw std::out_of_range if the deque is empty
+   */
+  T removeFirst();
+  T removeLast();
+  /* first() / last(): the item at the front / back, without removing it
+   *   >> throw std::out_of_range if the deque is empty
+   */
+  T &first();
+  T &last();
+
+  /* firstSegment(T *&ptr) / secondSegment(T *&ptr): the items as two
+   *      contiguous runs, items [0, n1) then [n1, size()); return the run
+   *      length and point "ptr" at its first item (secondSegment returns 0
+   *      when the items do not wrap around the end of the buffer)
+   */
+  int firstSegment(T *&ptr);
+  int secondSegment(T *&ptr);
+  /* copyTo(T *dst, int from = 0, int n = -1): copy items [from, from + n)
+   *      to dst with at most two bulk copies; n = -1 means up to size()
+   *   >> throw std::out_of_range if the range is invalid
+   */
+  void copyTo(T *dst, int from = 0, int n = -1);
+  /* linearize(): rotate the items to the start of the buffer so that they
+   *      are one contiguous run; return a pointer to item 0
+   */
+  T *linearize();
+
+  /* reserve(int minCapacity): make room for "minCapacity" items, rounded up
+   *      to a power of two
+   *   >> throw std::length_error past XDEQUE_MAX_CAPACITY items; adds that
+   *      would grow the buffer beyond it throw the same
+   */
+  void reserve(int minCapacity);
+  /* shrink_to_fit(): trim the buffer to the smallest power of two >= size()
+   */
+  void shrink_to_fit();
+  int getCapacity() { return capacity; }
+
+  Iterator begin() { return Iterator(this, 0); }
+  Iterator end() { return Iterator(this, count); }
+
+ protected:
+  int slot(int index) { return (head + index) & (capacity - 1); }
+  void ensureCapacity(int minCapacity);
+  void resizeStorage(int newCapacity);
+  void copyFrom(const XDeque<T> &list);
+  void removeInternalData();
+  static int roundCapacity(int minCapacity);
+
+  //! FUNTION STATIC
+ protected:
+  static bool equals(T &lhs, T &rhs, bool (*itemEqual)(T &, T &)) {
+    if (itemEqual == 0)
+      return lhs == rhs;
+    else
+      return itemEqual(lhs, rhs);
+  }
+
+ public:
+  static void free(XDeque<T> *list) {
+    typename XDeque<T>::Iterator it = list->begin();
+    while (it != list->end()) {
+      delete *it;
+      it++;
+    }
+  }
+
+ public:
+  class Iterator {
+   private:
+    int cursor;
+    XDeque<T> *pList;
+
+   public:
+    Iterator(XDeque<T> *pList = 0, int index = 0) {
+      this->pList = pList;
+      this->cursor = index;
+    }
+    Iterator(const Iterator &iterator)
+        : cursor(iterator.cursor), pList(iterator.pList) {}
+    Iterator &operator=(const Iterator &iterator) {
+      cursor = iterator.cursor;
+      pList = iterator.pList;
+      return *this;
+    }
+    void remove(void (*removeItemData)(T) = 0) {
+      T item = pList->removeAt(cursor);
+      if (removeItemData != 0) removeItemData(item);
+      cursor -= 1;  // MUST keep index of previous, for ++ later
+    }
+
+    T &operator*() { return pList->data[pList->slot(cursor)]; }
+    bool operator!=(const Iterator &iterator) {
+      return cursor != iterator.cursor;
+    }
+    // Prefix ++ overload
+    Iterator &operator++() {
+      this->cursor++;
+      return *this;
+    }
+    // Postfix ++ overload
+    Iterator operator++(int) {
+      Iterator iterator = *this;
+      ++*this;
+      return iterator;
+    }
+  };
+};
+
+//! ////////////////////////////////////////////////////////////////////
+//! //////////////////////     METHOD DEFNITION      ///////////////////
+//! ////////////////////////////////////////////////////////////////////
+template <class T>
+XDeque<T>::XDeque(void (*deleteUserData)(XDeque<T> *),
+                  bool (*itemEqual)(T &, T &), int capacity) {
+  this->deleteUserData = deleteUserData;
+  this->itemEqual = itemEqual;
+  this->initCapacity = roundCapacity(capacity);
+  this->capacity = initCapacity;
+  ALLOC_TAG(ALLOC_XDEQUE);
+  this->data = new T[this->capacity];
+  this->head = 0;
+  this->count = 0;
+}
+
+template <class T>
+XDeque<T>::XDeque(const XDeque<T> &list) {
+  this->data = nullptr;
+  this->capacity = 0;
+  this->head = 0;
+  this->count = 0;
+  copyFrom(list);
+}
+
+template <class T>
+XDeque<T> &XDeque<T>::operator=(const XDeque<T> &list) {
+  if (this == &list) return *this;
+  removeInternalData();
+  copyFrom(list);
+  return *this;
+}
+
+template <class T>
+XDeque<T>::~XDeque() {
+  removeInternalData();
+}
+
+template <class T>
+void XDeque<T>::add(T e) {
+  ensureCapacity(count + 1);
+  data[slot(count)] = std::move(e);
+  count++;
+}
+
+template <class T>
+void XDeque<T>::addFirst(T e) {
+  ensureCapacity(count + 1);
+  head = (head - 1) & (capacity - 1);
+  data[head] = std::move(e);
+  count++;
+}
+
+template <class T>
+void XDeque<T>::add(int index, T e) {
+  if (index < 0 || index > count) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  ensureCapacity(count + 1);
+  if (index < count - index) {
+    // open a gap by moving items [0, index) one slot towards the front
+    head = (head - 1) & (capacity - 1);
+    for (int i = 0; i < index; i++) {
+      data[slot(i)] = std::move(data[slot(i + 1)]);
+    }
+  } else {
+    for (int i = count; i > index; i--) {
+      data[slot(i)] = std::move(data[slot(i - 1)]);
+    }
+  }
+  data[slot(index)] = std::move(e);
+  count++;
+}
+
+template <class T>
+T XDeque<T>::removeAt(int index) {
+  if (index < 0 || index >= count) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  T removedItem = std::move(data[slot(index)]);
+  if (index < count - 1 - index) {
+    for (int i = index; i > 0; i--) {
+      data[slot(i)] = std::move(data[slot(i - 1)]);
+    }
+    head = (head + 1) & (capacity - 1);
+  } else {
+    for (int i = index; i < count - 1; i++) {
+      data[slot(i)] = std::move(data[slot(i + 1)]);
+    }
+  }
+  count--;
+  return removedItem;
+}
+
+template <class T>
+T XDeque<T>::removeFirst() {
+  if (count == 0) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  T removedItem = std::move(data[head]);
+  head = (head + 1) & (capacity - 1);
+  count--;
+  return removedItem;
+}
+
+template <class T>
+T XDeque<T>::removeLast() {
+  if (count == 0) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  count--;
+  return std::move(data[slot(count)]);
+}
+
+template <class T>
+T &XDeque<T>::first() {
+  if (count == 0) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  return data[head];
+}
+
+template <class T>
+T &XDeque<T>::last() {
+  if (count == 0) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  return data[slot(count - 1)];
+}
+
+template <class T>
+bool XDeque<T>::removeItem(T item, void (*removeItemData)(T)) {
+  for (int i = 0; i < count; i++) {
+    T &current = data[slot(i)];
+    if (equals(current, item, itemEqual)) {
+      if (removeItemData != nullptr) {
+        removeItemData(current);
+      }
+      removeAt(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class T>
+bool XDeque<T>::empty() {
+  return count == 0;
+}
+
+template <class T>
+int XDeque<T>::size() {
+  return count;
+}
+
+template <class T>
+void XDeque<T>::clear() {
+  removeInternalData();
+  capacity = initCapacity;
+  ALLOC_TAG(ALLOC_XDEQUE);
+  data = new T[capacity];
+}
+
+template <class T>
+T &XDeque<T>::get(int index) {
+  if (index < 0 || index >= count) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  return data[slot(index)];
+}
+
+template <class T>
+int XDeque<T>::indexOf(T item) {
+  for (int i = 0; i < count; i++) {
+    if (equals(data[slot(i)], item, itemEqual)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+template <class T>
+bool XDeque<T>::contains(T item) {
+  return indexOf(item) != -1;
+}
+
+template <class T>
+string XDeque<T>::toString(string (*item2str)(T &)) {
+  stringstream ss;
+  ss << "[";
+  for (int i = 0; i < count; i++) {
+    T &item = data[slot(i)];
+    if (item2str) {
+      ss << item2str(item);
+    } else if constexpr (std::is_pointer_v<T>) {
+      ss << *item;
+    } else {
+      ss << item;
+    }
+    if (i < count - 1) ss << ", ";
+  }
+  ss << "]";
+  return ss.str();
+}
+
+template <class T>
+int XDeque<T>::firstSegment(T *&ptr) {
+  ptr = data + head;
+  return min(count, capacity - head);
+}
+
+template <class T>
+int XDeque<T>::secondSegment(T *&ptr) {
+  ptr = data;
+  return max(0, count - (capacity - head));
+}
+
+template <class T>
+void XDeque<T>::copyTo(T *dst, int from, int n) {
+  if (n < 0) n = count - from;
+  if (from < 0 || n < 0 || from + n > count) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  int start = slot(from);
+  int run = min(n, capacity - start);
+  std::copy(data + start, data + start + run, dst);
+  std::copy(data, data + (n - run), dst + run);
+}
+
+template <class T>
+T *XDeque<T>::linearize() {
+  if (head + count > capacity) {
+    std::rotate(data, data + head, data + capacity);
+    head = 0;
+  } else if (head != 0) {
+    std::move(data + head, data + head + count, data);
+    head = 0;
+  }
+  return data;
+}
+
+template <class T>
+void XDeque<T>::reserve(int minCapacity) {
+  if (minCapacity > capacity) resizeStorage(roundCapacity(minCapacity));
+}
+
+template <class T>
+void XDeque<T>::shrink_to_fit() {
+  int newCapacity = roundCapacity(max(count, 1));
+  if (newCapacity < capacity) resizeStorage(newCapacity);
+}
+
+template <class T>
+void XDeque<T>::ensureCapacity(int minCapacity) {
+  if (minCapacity > capacity) {
+    resizeStorage(roundCapacity(minCapacity));
+  }
+}
+
+template <class T>
+void XDeque<T>::resizeStorage(int newCapacity) {
+  // items are unwrapped to start at slot 0 of the new buffer
+  T *newData;
+  {
+    ALLOC_TAG(ALLOC_XDEQUE);
+    newData = new T[newCapacity];
+  }
+  int run = min(count, capacity - head);
+  std::move(data + head, data + head + run, newData);
+  std::move(data, data + (count - run), newData + run);
+  delete[] data;
+  data = newData;
+  capacity = newCapacity;
+  head = 0;
+}
+
+template <class T>
+void XDeque<T>::copyFrom(const XDeque<T> &list) {
+  this->itemEqual = list.itemEqual;
+  this->deleteUserData = list.deleteUserData;
+  this->initCapacity = list.initCapacity;
+  this->capacity = roundCapacity(max(list.count, list.initCapacity));
+  ALLOC_TAG(ALLOC_XDEQUE);
+  this->data = new T[this->capacity];
+  this->head = 0;
+  for (int i = 0; i < list.count; i++) {
+    this->data[i] = list.data[(list.head + i) & (list.capacity - 1)];
+  }
+  this->count = list.count;
+}
+
+template <class T>
+void XDeque<T>::removeInternalData() {
+  if (deleteUserData != nullptr) {
+    deleteUserData(this);
+  }
+  delete[] data;
+  data = nullptr;
+  capacity = 0;
+  head = 0;
+  count = 0;
+}
+
+template <class T>
+int XDeque<T>::roundCapacity(int minCapacity) {
+  if (minCapacity > XDEQUE_MAX_CAPACITY)
+    throw std::length_error("XDeque: capacity is out of range!");
+  int capacity = 1;
+  while (capacity < minCapacity) capacity <<= 1;
+  return capacity;
+}
+
+#endif /* XDEQUE_H */
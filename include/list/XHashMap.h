@@ -0,0 +1,436 @@
+/*
+ * File:   XHashMap.h
+ *
+ * XHashMap<K, V, Hash>: a hash map with flat open addressing and Robin Hood
+ * linear probing.
+ *   >> entries live in one array of capacity (a power of two) slots; a
+ *      separate array holds each slot's probe distance + 1 (0: empty), so
+ *      probing only touches a key whose distance matches
+ *   >> Robin Hood: an insert takes the slot of any entry that is closer to
+ *      its home slot than the new one, which keeps probe lengths short and
+ *      lets a lookup stop as soon as it meets such an entry
+ *   >> remove shifts the following entries back (no tombstones)
+ *   >> the table doubles when it is 7/8 full
+ * Hash is a policy (std::hash<K> by default); its result is mixed with a
+ * Fibonacci multiply, so identity hashes of integers are fine. Keys are
+ * compared with keyEqual if given, operator== otherwise, like the lists'
+ * itemEqual.
+ */
+
+#ifndef XHASHMAP_H
+#define XHASHMAP_H
+#include "list/XArrayList.h"
+#include "util/AllocTracker.h"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+#define XHASHMAP_MAX_CAPACITY (1 << 30)  // largest power of two an int holds
+
+template <class K, class V, class Hash = std::hash<K>>
+class XHashMap {
+ public:
+  class Iterator;  // forward declaration
+
+  struct Entry {
+    K key;
+    V value;
+  };
+
+ protected:
+  Entry *slots;
+  int32_t *dist;  // probe distance + 1, 0 for an empty slot
+  int capacity;   // power of two
+  int shift;      // 64 - log2(capacity)
+  int count;
+  int initCapacity;
+  Hash hasher;
+  bool (*keyEqual)(K &lhs, K &rhs);
+  void (*deleteUserData)(XHashMap<K, V, Hash> *);
+
+ public:
+  XHashMap(void (*deleteUserData)(XHashMap<K, V, Hash> *) = 0,
+           bool (*keyEqual)(K &, K &) = 0, int capacity = 16);
+  XHashMap(const XHashMap<K, V, Hash> &map);
+  XHashMap<K, V, Hash> &operator=(const XHashMap<K, V, Hash> &map);
+  ~XHashMap();
+
+  /* put(K key, V value): add "key" -> "value", or replace the value if
+   *      "key" is already in the map
+   */
+  void put(K key, V value);
+  /* get(K key): return a reference to the value of "key"
+   *   >> throw std::out_of_range if "key" is not in the map
+   */
+  V &get(const K &key);
+  /* find(K key): pointer to the value of "key", or nullptr
+   */
+  V *find(const K &key);
+  /* operator[](K key): value of "key", inserting V() first if needed
+   */
+  V &operator[](K key);
+  bool containsKey(const K &key) { return find(key) != nullptr; }
+  /* remove(K key, deleteKeyInMap, deleteValueInMap): remove "key"; the
+   *      optional functions are called on the stored key / value first
+   *      (e.g. to delete pointers), like removeItem's removeItemData
+   * return:
+   *   >> true if "key" was in the map, false otherwise
+   */
+  bool remove(const K &key, void (*deleteKeyInMap)(K) = 0,
+              void (*deleteValueInMap)(V) = 0);
+
+  bool empty() { return count == 0; }
+  int size() { return count; }
+  void clear();
+  /* reserve(int n): make room for "n" entries without rehashing
+   *   >> throw std::length_error if that needs more than
+   *      XHASHMAP_MAX_CAPACITY slots; so does a put that would
+   */
+  void reserve(int n);
+  int getCapacity() { return capacity; }
+  double getLoadFactor() { return (double)count / capacity; }
+
+  XArrayList<K> keys();
+  XArrayList<V> values();
+
+  string toString(string (*key2str)(K &) = 0, string (*value2str)(V &) = 0);
+  void println(string (*key2str)(K &) = 0, string (*value2str)(V &) = 0) {
+    cout << toString(key2str, value2str) << endl;
+  }
+  void setDeleteUserDataPtr(void (*deleteUserData)(XHashMap<K, V, Hash> *) = 0) {
+    this->deleteUserData = deleteUserData;
+  }
+
+  Iterator begin() { return Iterator(this, nextUsed(0)); }
+  Iterator end() { return Iterator(this, capacity); }
+
+ protected:
+  int home(const K &key) {
+    uint64_t h = (uint64_t)hasher(key) * 0x9E3779B97F4A7C15ull;
+    return (int)(h >> shift);
+  }
+  int findSlot(const K &key);
+  Entry &insertNew(K key, V value);
+  void resizeStorage(int newCapacity);
+  void allocate(int newCapacity);
+  void copyFrom(const XHashMap<K, V, Hash> &map);
+  void removeInternalData();
+  int nextUsed(int slot) {
+    while (slot < capacity && dist[slot] == 0) slot++;
+    return slot;
+  }
+  static int roundCapacity(int minCapacity) {
+    if (minCapacity > XHASHMAP_MAX_CAPACITY)
+      throw std::length_error("XHashMap: capacity is out of range!");
+    int capacity = 8;
+    while (capacity < minCapacity) capacity <<= 1;
+    return capacity;
+  }
+
+  //! FUNTION STATIC
+ protected:
+  static bool equals(K &lhs, K &rhs, bool (*keyEqual)(K &, K &)) {
+    if (keyEqual == 0)
+      return lhs == rhs;
+    else
+      return keyEqual(lhs, rhs);
+  }
+
+ public:
+  /* freeKeys / freeValues / freeAll: deleteUserData functions for maps of
+   *      pointers
+   */
+  static void freeKeys(XHashMap<K, V, Hash> *map) {
+    for (Iterator it = map->begin(); it != map->end(); it++) delete (*it).key;
+  }
+  static void freeValues(XHashMap<K, V, Hash> *map) {
+    for (Iterator it = map->begin(); it != map->end(); it++) delete (*it).value;
+  }
+  static void freeAll(XHashMap<K, V, Hash> *map) {
+    freeKeys(map);
+    freeValues(map);
+  }
+
+ public:
+  class Iterator {
+   private:
+    int cursor;
+    XHashMap<K, V, Hash> *pMap;
+
+   public:
+    Iterator(XHashMap<K, V, Hash> *pMap = 0, int slot = 0) {
+      this->pMap = pMap;
+      this->cursor = slot;
+    }
+    Iterator(const Iterator &iterator)
+        : cursor(iterator.cursor), pMap(iterator.pMap) {}
+    Iterator &operator=(const Iterator &iterator) {
+      cursor = iterator.cursor;
+      pMap = iterator.pMap;
+      return *this;
+    }
+
+    Entry &operator*() { return pMap->slots[cursor]; }
+    K &key() { return pMap->slots[cursor].key; }
+    V &value() { return pMap->slots[cursor].value; }
+    bool operator!=(const Iterator &iterator) {
+      return cursor != iterator.cursor;
+    }
+    // Prefix ++ overload
+    Iterator &operator++() {
+      cursor = pMap->nextUsed(cursor + 1);
+      return *this;
+    }
+    // Postfix ++ overload
+    Iterator operator++(int) {
+      Iterator iterator = *this;
+      ++*this;
+      return iterator;
+    }
+  };
+};
+
+//! ////////////////////////////////////////////////////////////////////
+//! //////////////////////     METHOD DEFNITION      ///////////////////
+//! ////////////////////////////////////////////////////////////////////
+template <class K, class V, class Hash>
+XHashMap<K, V, Hash>::XHashMap(void (*deleteUserData)(XHashMap<K, V, Hash> *),
+                               bool (*keyEqual)(K &, K &), int capacity) {
+  this->deleteUserData = deleteUserData;
+  this->keyEqual = keyEqual;
+  this->initCapacity = roundCapacity(capacity);
+  this->count = 0;
+  allocate(initCapacity);
+}
+
+template <class K, class V, class Hash>
+XHashMap<K, V, Hash>::XHashMap(const XHashMap<K, V, Hash> &map) {
+  copyFrom(map);
+}
+
+template <class K, class V, class Hash>
+XHashMap<K, V, Hash> &XHashMap<K, V, Hash>::operator=(const XHashMap<K, V, Hash> &map) {
+  if (this == &map) return *this;
+  removeInternalData();
+  copyFrom(map);
+  return *this;
+}
+
+template <class K, class V, class Hash>
+XHashMap<K, V, Hash>::~XHashMap() {
+  removeInternalData();
+}
+
+template <class K, class V, class Hash>
+void XHashMap<K, V, Hash>::put(K key, V value) {
+  int slot = findSlot(key);
+  if (slot >= 0)
+    slots[slot].value = std::move(value);
+  else
+    insertNew(std::move(key), std::move(value));
+}
+
+template <class K, class V, class Hash>
+V &XHashMap<K, V, Hash>::get(const K &key) {
+  int slot = findSlot(key);
+  if (slot < 0) {
+    throw std::out_of_range("Key is not in the map!");
+  }
+  return slots[slot].value;
+}
+
+template <class K, class V, class Hash>
+V *XHashMap<K, V, Hash>::find(const K &key) {
+  int slot = findSlot(key);
+  return (slot < 0) ? nullptr : &slots[slot].value;
+}
+
+template <class K, class V, class Hash>
+V &XHashMap<K, V, Hash>::operator[](K key) {
+  int slot = findSlot(key);
+  if (slot >= 0) return slots[slot].value;
+  return insertNew(std::move(key), V()).value;
+}
+
+template <class K, class V, class Hash>
+bool XHashMap<K, V, Hash>::remove(const K &key, void (*deleteKeyInMap)(K),
+                                  void (*deleteValueInMap)(V)) {
+  int slot = findSlot(key);
+  if (slot < 0) return false;
+  if (deleteKeyInMap != nullptr) deleteKeyInMap(slots[slot].key);
+  if (deleteValueInMap != nullptr) deleteValueInMap(slots[slot].value);
+
+  // backward shift: pull every displaced follower one slot closer to home
+  int mask = capacity - 1;
+  int next = (slot + 1) & mask;
+  while (dist[next] > 1) {
+    slots[slot] = std::move(slots[next]);
+    dist[slot] = dist[next] - 1;
+    slot = next;
+    next = (next + 1) & mask;
+  }
+  dist[slot] = 0;
+  if constexpr (!std::is_trivially_destructible<Entry>::value) {
+    slots[slot] = Entry();  // release what the vacated slot still owns
+  }
+  count--;
+  return true;
+}
+
+template <class K, class V, class Hash>
+void XHashMap<K, V, Hash>::clear() {
+  removeInternalData();
+  allocate(initCapacity);
+}
+
+template <class K, class V, class Hash>
+void XHashMap<K, V, Hash>::reserve(int n) {
+  if (n > XHASHMAP_MAX_CAPACITY)
+    throw std::length_error("XHashMap: capacity is out of range!");
+  int newCapacity = roundCapacity(n + n / 7 + 1);
+  if (newCapacity > capacity) resizeStorage(newCapacity);
+}
+
+template <class K, class V, class Hash>
+XArrayList<K> XHashMap<K, V, Hash>::keys() {
+  XArrayList<K> list(0, 0, count > 0 ? count : 1);
+  for (Iterator it = begin(); it != end(); it++) list.add(it.key());
+  return list;
+}
+
+template <class K, class V, class Hash>
+XArrayList<V> XHashMap<K, V, Hash>::values() {
+  XArrayList<V> list(0, 0, count > 0 ? count : 1);
+  for (Iterator it = begin(); it != end(); it++) list.add(it.value());
+  return list;
+}
+
+template <class K, class V, class Hash>
+string XHashMap<K, V, Hash>::toString(string (*key2str)(K &), string (*value2str)(V &)) {
+  stringstream ss;
+  ss << "{";
+  bool first = true;
+  for (Iterator it = begin(); it != end(); it++) {
+    if (!first) ss << ", ";
+    first = false;
+    if (key2str)
+      ss << key2str(it.key());
+    else
+      ss << it.key();
+    ss << ": ";
+    if (value2str)
+      ss << value2str(it.value());
+    else
+      ss << it.value();
+  }
+  ss << "}";
+  return ss.str();
+}
+
+template <class K, class V, class Hash>
+int XHashMap<K, V, Hash>::findSlot(const K &key) {
+  int mask = capacity - 1;
+  int slot = home(key);
+  // an entry closer to its home than we are to ours means "key" is absent
+  for (int d = 1; dist[slot] >= d; d++) {
+    if (dist[slot] == d && equals(slots[slot].key, const_cast<K &>(key), keyEqual))
+      return slot;
+    slot = (slot + 1) & mask;
+  }
+  return -1;
+}
+
+template <class K, class V, class Hash>
+typename XHashMap<K, V, Hash>::Entry &XHashMap<K, V, Hash>::insertNew(K key, V value) {
+  if ((long)(count + 1) * 8 > (long)capacity * 7) {
+    if (capacity >= XHASHMAP_MAX_CAPACITY)
+      throw std::length_error("XHashMap: capacity is out of range!");
+    resizeStorage(2 * capacity);
+  }
+
+  Entry carried = {std::move(key), std::move(value)};
+  int mask = capacity - 1;
+  int slot = home(carried.key);
+  int d = 1;
+  int placed = -1;  // where the new entry ended up
+  while (true) {
+    if (dist[slot] == 0) {
+      slots[slot] = std::move(carried);
+      dist[slot] = d;
+      count++;
+      return slots[placed < 0 ? slot : placed];
+    }
+    if (dist[slot] < d) {
+      // rob the richer entry and carry it on
+      std::swap(carried, slots[slot]);
+      int robbed = dist[slot];
+      dist[slot] = d;
+      d = robbed;
+      if (placed < 0) placed = slot;
+    }
+    slot = (slot + 1) & mask;
+    d++;
+  }
+}
+
+template <class K, class V, class Hash>
+void XHashMap<K, V, Hash>::resizeStorage(int newCapacity) {
+  Entry *oldSlots = slots;
+  int32_t *oldDist = dist;
+  int oldCapacity = capacity;
+  int oldCount = count;
+  allocate(newCapacity);
+  for (int i = 0; i < oldCapacity; i++) {
+    if (oldDist[i] != 0) insertNew(std::move(oldSlots[i].key), std::move(oldSlots[i].value));
+  }
+  count = oldCount;
+  delete[] oldSlots;
+  delete[] oldDist;
+}
+
+template <class K, class V, class Hash>
+void XHashMap<K, V, Hash>::allocate(int newCapacity) {
+  ALLOC_TAG(ALLOC_OTHER);
+  slots = new Entry[newCapacity];
+  dist = new int32_t[newCapacity];
+  memset(dist, 0, newCapacity * sizeof(int32_t));
+  capacity = newCapacity;
+  shift = 64;
+  for (int c = newCapacity; c > 1; c >>= 1) shift--;
+  count = 0;
+}
+
+template <class K, class V, class Hash>
+void XHashMap<K, V, Hash>::copyFrom(const XHashMap<K, V, Hash> &map) {
+  this->keyEqual = map.keyEqual;
+  this->deleteUserData = map.deleteUserData;
+  this->hasher = map.hasher;
+  this->initCapacity = map.initCapacity;
+  allocate(map.capacity);
+  for (int i = 0; i < capacity; i++) {
+    slots[i] = map.slots[i];
+    dist[i] = map.dist[i];
+  }
+  count = map.count;
+}
+
+template <class K, class V, class Hash>
+void XHashMap<K, V, Hash>::removeInternalData() {
+  if (deleteUserData != nullptr) {
+    deleteUserData(this);
+  }
+  delete[] slots;
+  delete[] dist;
+  slots = nullptr;
+  dist = nullptr;
+  capacity = 0;
+  count = 0;
+}
+
+#endif /* XHASHMAP_H */
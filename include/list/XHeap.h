@@ -0,0 +1,324 @@
+/*
+ * File:   XHeap.h
+ *
+ * XHeap<T, Cmp, D>: a D-ary heap (priority queue) stored in an XArrayList.
+ * Like std::priority_queue, top() is the item that is not "less" than any
+ * other under cmp, so XHeap<int> is a max-heap and
+ * XHeap<int, std::greater<int>> is a min-heap. D = 2 is the usual binary
+ * heap; D = 4 halves the depth and keeps the children of a node in one or
+ * two cache lines, which usually makes pop() faster for large heaps.
+ *
+ *   >> push / pop: O(log_D n); top: O(1); heapify: O(n)
+ *   >> indexed heaps (XHeap(cmp, true)) return a handle from push() that
+ *      stays valid until the item leaves the heap; update(handle, item) and
+ *      remove(handle) then work in O(log_D n) (decrease-key)
+ *   >> bounded heaps (setBound(k)) keep only k items: once full, push()
+ *      replaces top() if the new item is "less" than it, otherwise drops
+ *      the new item. XHeap<int, std::greater<int>> bounded to k therefore
+ *      keeps the k largest items of a stream, with the smallest of them on
+ *      top.
+ */
+
+#ifndef XHEAP_H
+#define XHEAP_H
+#include "list/XArrayList.h"
+#include <functional>
+#include <stdexcept>
+#include <utility>
+using namespace std;
+
+template <class T, class Cmp = std::less<T>, int D = 2>
+class XHeap {
+  static_assert(D >= 2, "XHeap needs at least two children per node");
+
+ protected:
+  XArrayList<T> items;        // heap order: children of i are D*i+1 .. D*i+D
+  XArrayList<int> handleOf;   // indexed only: slot -> handle
+  XArrayList<int> positionOf; // indexed only: handle -> slot, -1 if free
+  XArrayList<int> freeHandles;
+  Cmp cmp;
+  bool indexed;
+  int bound;  // 0: unbounded
+
+ public:
+  XHeap(Cmp cmp = Cmp(), bool indexed = false);
+  XHeap(XArrayList<T> &list, Cmp cmp = Cmp(), bool indexed = false);
+
+  /* push(T e): add "e"
+   * return:
+   *   >> the handle of "e" for an indexed heap, -1 otherwise
+   *   >> -1 if a full bounded heap dropped "e"
+   */
+  int push(T e);
+  /* pop(): remove and return top()
+   *   >> throw std::out_of_range if the heap is empty
+   */
+  T pop();
+  /* top(): the item with the highest priority; do not change its key in
+   *      place, use update() on an indexed heap instead
+   *   >> throw std::out_of_range if the heap is empty
+   */
+  T &top();
+  /* heapify(XArrayList<T> &list): replace the content with the items of
+   *      "list", bottom-up in O(n); a bounded heap keeps the best "bound"
+   */
+  void heapify(XArrayList<T> &list);
+  /* drain(XArrayList<T> &out): pop every item into "out", in pop order
+   */
+  void drain(XArrayList<T> &out);
+
+  /* update(int handle, T e): replace the item of "handle" by "e" and
+   *      restore the heap order, whichever way the key moved
+   * remove(int handle): remove and return the item of "handle"
+   * get(int handle): the item of "handle"
+   *   >> indexed heaps only; throw std::invalid_argument if "handle" is
+   *      not in the heap
+   */
+  void update(int handle, T e);
+  T remove(int handle);
+  T &get(int handle);
+  bool contains(int handle);
+
+  /* setBound(int k): keep at most k items (k = 0: unbounded); pops the
+   *      surplus if the heap holds more than k
+   *   >> throw std::invalid_argument if k < 0
+   */
+  void setBound(int k);
+  int getBound() { return bound; }
+
+  int size() { return items.size(); }
+  bool empty() { return items.empty(); }
+  void clear();
+  void reserve(int minCapacity) { items.reserve(minCapacity); }
+
+  string toString(string (*item2str)(T &) = 0) { return items.toString(item2str); }
+  void println(string (*item2str)(T &) = 0) { items.println(item2str); }
+
+ protected:
+  T *base() { return &items.get(0); }
+  void place(int slot, int handle) {
+    handleOf.get(slot) = handle;
+    positionOf.get(handle) = slot;
+  }
+  int newHandle();
+  void siftUp(int slot);
+  void siftDown(int slot);
+  void removeSlot(int slot);
+  void checkHandle(int handle);
+};
+
+//! ////////////////////////////////////////////////////////////////////
+//! //////////////////////     METHOD DEFNITION      ///////////////////
+//! ////////////////////////////////////////////////////////////////////
+template <class T, class Cmp, int D>
+XHeap<T, Cmp, D>::XHeap(Cmp cmp, bool indexed) : cmp(cmp) {
+  this->indexed = indexed;
+  this->bound = 0;
+}
+
+template <class T, class Cmp, int D>
+XHeap<T, Cmp, D>::XHeap(XArrayList<T> &list, Cmp cmp, bool indexed) : cmp(cmp) {
+  this->indexed = indexed;
+  this->bound = 0;
+  heapify(list);
+}
+
+template <class T, class Cmp, int D>
+int XHeap<T, Cmp, D>::push(T e) {
+  int n = items.size();
+  if (bound > 0 && n >= bound) {
+    // full: "e" only gets in if it beats the weakest item kept, top()
+    if (!cmp(e, items.get(0))) return -1;
+    int handle = -1;
+    if (indexed) {
+      positionOf.get(handleOf.get(0)) = -1;
+      freeHandles.add(handleOf.get(0));
+      handle = newHandle();
+      place(0, handle);
+    }
+    items.get(0) = std::move(e);
+    siftDown(0);
+    return handle;
+  }
+  items.add(std::move(e));
+  int handle = -1;
+  if (indexed) {
+    handle = newHandle();
+    handleOf.add(0);
+    place(n, handle);
+  }
+  siftUp(n);
+  return handle;
+}
+
+template <class T, class Cmp, int D>
+T XHeap<T, Cmp, D>::pop() {
+  if (items.empty()) {
+    throw std::out_of_range("Heap is empty!");
+  }
+  T topItem = std::move(items.get(0));
+  removeSlot(0);
+  return topItem;
+}
+
+template <class T, class Cmp, int D>
+T &XHeap<T, Cmp, D>::top() {
+  if (items.empty()) {
+    throw std::out_of_range("Heap is empty!");
+  }
+  return items.get(0);
+}
+
+template <class T, class Cmp, int D>
+void XHeap<T, Cmp, D>::heapify(XArrayList<T> &list) {
+  clear();
+  int n = list.size();
+  int kept = (bound > 0 && n > bound) ? bound : n;
+  items.reserve(kept);
+  for (int i = 0; i < kept; i++) {
+    items.add(list.get(i));
+    if (indexed) {
+      handleOf.add(0);
+      place(i, newHandle());
+    }
+  }
+  for (int i = (kept - 2) / D; kept > 1 && i >= 0; i--) siftDown(i);
+  for (int i = kept; i < n; i++) push(list.get(i));
+}
+
+template <class T, class Cmp, int D>
+void XHeap<T, Cmp, D>::drain(XArrayList<T> &out) {
+  out.reserve(out.size() + items.size());
+  while (!items.empty()) out.add(pop());
+}
+
+template <class T, class Cmp, int D>
+void XHeap<T, Cmp, D>::update(int handle, T e) {
+  checkHandle(handle);
+  int slot = positionOf.get(handle);
+  T &item = items.get(slot);
+  bool up = cmp(item, e);
+  item = std::move(e);
+  if (up)
+    siftUp(slot);
+  else
+    siftDown(slot);
+}
+
+template <class T, class Cmp, int D>
+T XHeap<T, Cmp, D>::remove(int handle) {
+  checkHandle(handle);
+  int slot = positionOf.get(handle);
+  T removedItem = std::move(items.get(slot));
+  removeSlot(slot);
+  return removedItem;
+}
+
+template <class T, class Cmp, int D>
+T &XHeap<T, Cmp, D>::get(int handle) {
+  checkHandle(handle);
+  return items.get(positionOf.get(handle));
+}
+
+template <class T, class Cmp, int D>
+bool XHeap<T, Cmp, D>::contains(int handle) {
+  return indexed && handle >= 0 && handle < positionOf.size() &&
+         positionOf.get(handle) >= 0;
+}
+
+template <class T, class Cmp, int D>
+void XHeap<T, Cmp, D>::setBound(int k) {
+  if (k < 0) {
+    throw std::invalid_argument("Heap bound must not be negative!");
+  }
+  bound = k;
+  while (bound > 0 && items.size() > bound) pop();
+}
+
+template <class T, class Cmp, int D>
+void XHeap<T, Cmp, D>::clear() {
+  items.clear();
+  handleOf.clear();
+  positionOf.clear();
+  freeHandles.clear();
+}
+
+template <class T, class Cmp, int D>
+int XHeap<T, Cmp, D>::newHandle() {
+  if (!freeHandles.empty()) return freeHandles.removeAt(freeHandles.size() - 1);
+  positionOf.add(-1);
+  return positionOf.size() - 1;
+}
+
+template <class T, class Cmp, int D>
+void XHeap<T, Cmp, D>::siftUp(int slot) {
+  // move the item up through a hole instead of swapping at every level
+  T *a = base();
+  T item = std::move(a[slot]);
+  int handle = indexed ? handleOf.get(slot) : -1;
+  while (slot > 0) {
+    int parent = (slot - 1) / D;
+    if (!cmp(a[parent], item)) break;
+    a[slot] = std::move(a[parent]);
+    if (indexed) place(slot, handleOf.get(parent));
+    slot = parent;
+  }
+  a[slot] = std::move(item);
+  if (indexed) place(slot, handle);
+}
+
+template <class T, class Cmp, int D>
+void XHeap<T, Cmp, D>::siftDown(int slot) {
+  T *a = base();
+  int n = items.size();
+  T item = std::move(a[slot]);
+  int handle = indexed ? handleOf.get(slot) : -1;
+  while (true) {
+    int first = D * slot + 1;
+    if (first >= n) break;
+    int last = min(first + D, n);
+    int best = first;
+    for (int child = first + 1; child < last; child++) {
+      if (cmp(a[best], a[child])) best = child;
+    }
+    if (!cmp(item, a[best])) break;
+    a[slot] = std::move(a[best]);
+    if (indexed) place(slot, handleOf.get(best));
+    slot = best;
+  }
+  a[slot] = std::move(item);
+  if (indexed) place(slot, handle);
+}
+
+template <class T, class Cmp, int D>
+void XHeap<T, Cmp, D>::removeSlot(int slot) {
+  // the item at "slot" has been moved out; fill the hole with the last item
+  int last = items.size() - 1;
+  if (indexed) {
+    int handle = handleOf.get(slot);
+    positionOf.get(handle) = -1;
+    freeHandles.add(handle);
+  }
+  if (slot != last) {
+    T *a = base();
+    a[slot] = std::move(a[last]);
+    if (indexed) place(slot, handleOf.get(last));
+  }
+  items.removeAt(last);
+  if (indexed) handleOf.removeAt(last);
+  if (slot != last) {
+    if (slot > 0 && cmp(items.get((slot - 1) / D), items.get(slot)))
+      siftUp(slot);
+    else
+      siftDown(slot);
+  }
+}
+
+template <class T, class Cmp, int D>
+void XHeap<T, Cmp, D>::checkHandle(int handle) {
+  if (!contains(handle)) {
+    throw std::invalid_argument("Handle is not in the heap!");
+  }
+}
+
+#endif /* XHEAP_H */
@@ -0,0 +1,344 @@
+/*
+ * File:   XSmallList.h
+ *
+ * XSmallList<T, N>: an array list that keeps up to N items inside the
+ * object itself and only moves to heap storage when it grows past N.
+ * Lists that stay small (labels of one sample, a handful of neighbours, ...)
+ * never allocate. The API is the same as XArrayList.
+ */
+
+#ifndef XSMALLLIST_H
+#define XSMALLLIST_H
+#include "list/IList.h"
+#include "util/AllocTracker.h"
+#include <sstream>
+#include <stdexcept>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+template <class T, int N = 4>
+class XSmallList : public IList<T> {
+  static_assert(N > 0, "XSmallList needs at least one inline slot");
+
+ public:
+  class Iterator;  // forward declaration
+
+ protected:
+  T inlineData[N];  // used while capacity == N
+  T *data;          // == inlineData, or heap storage of "capacity" items
+  int capacity;
+  int count;
+  bool (*itemEqual)(T &lhs, T &rhs);
+  void (*deleteUserData)(XSmallList<T, N> *);
+
+ public:
+  XSmallList(void (*deleteUserData)(XSmallList<T, N> *) = 0,
+             bool (*itemEqual)(T &, T &) = 0);
+  XSmallList(const XSmallList<T, N> &list);
+  XSmallList<T, N> &operator=(const XSmallList<T, N> &list);
+  ~XSmallList();
+
+  // Inherit from IList: BEGIN
+  void add(T e);
+  void add(int index, T e);
+  T removeAt(int index);
+  bool removeItem(T item, void (*removeItemData)(T) = 0);
+  bool empty();
+  int size();
+  void clear();
+  T &get(int index);
+  int indexOf(T item);
+  bool contains(T item);
+  string toString(string (*item2str)(T &) = 0);
+  // Inherit from IList: END
+
+  void println(string (*item2str)(T &) = 0) {
+    cout << toString(item2str) << endl;
+  }
+  void setDeleteUserDataPtr(void (*deleteUserData)(XSmallList<T, N> *) = 0) {
+    this->deleteUserData = deleteUserData;
+  }
+
+  /* reserve(int minCapacity): make room for "minCapacity" items; moves to
+   *      the heap if minCapacity > N
+   */
+  void reserve(int minCapacity);
+  /* shrink_to_fit(): move back into the inline slots if size() <= N,
+   *      otherwise trim the heap storage to size()
+   */
+  void shrink_to_fit();
+  int getCapacity() { return capacity; }
+  bool isInline() { return data == inlineData; }
+
+  Iterator begin() { return Iterator(this, 0); }
+  Iterator end() { return Iterator(this, count); }
+
+ protected:
+  void ensureCapacity(int minCapacity);
+  void moveStorage(int newCapacity);
+  void copyFrom(const XSmallList<T, N> &list);
+  void removeInternalData();
+
+  //! FUNTION STATIC
+ protected:
+  static bool equals(T &lhs, T &rhs, bool (*itemEqual)(T &, T &)) {
+    if (itemEqual == 0)
+      return lhs == rhs;
+    else
+      return itemEqual(lhs, rhs);
+  }
+
+ public:
+  static void free(XSmallList<T, N> *list) {
+    typename XSmallList<T, N>::Iterator it = list->begin();
+    while (it != list->end()) {
+      delete *it;
+      it++;
+    }
+  }
+
+ public:
+  class Iterator {
+   private:
+    int cursor;
+    XSmallList<T, N> *pList;
+
+   public:
+    Iterator(XSmallList<T, N> *pList = 0, int index = 0) {
+      this->pList = pList;
+      this->cursor = index;
+    }
+    Iterator(const Iterator &iterator)
+        : cursor(iterator.cursor), pList(iterator.pList) {}
+    Iterator &operator=(const Iterator &iterator) {
+      cursor = iterator.cursor;
+      pList = iterator.pList;
+      return *this;
+    }
+    void remove(void (*removeItemData)(T) = 0) {
+      T item = pList->removeAt(cursor);
+      if (removeItemData != 0) removeItemData(item);
+      cursor -= 1;  // MUST keep index of previous, for ++ later
+    }
+
+    T &operator*() { return pList->data[cursor]; }
+    bool operator!=(const Iterator &iterator) {
+      return cursor != iterator.cursor;
+    }
+    // Prefix ++ overload
+    Iterator &operator++() {
+      this->cursor++;
+      return *this;
+    }
+    // Postfix ++ overload
+    Iterator operator++(int) {
+      Iterator iterator = *this;
+      ++*this;
+      return iterator;
+    }
+  };
+};
+
+//! ////////////////////////////////////////////////////////////////////
+//! //////////////////////     METHOD DEFNITION      ///////////////////
+//! ////////////////////////////////////////////////////////////////////
+template <class T, int N>
+XSmallList<T, N>::XSmallList(void (*deleteUserData)(XSmallList<T, N> *),
+                             bool (*itemEqual)(T &, T &)) {
+  this->deleteUserData = deleteUserData;
+  this->itemEqual = itemEqual;
+  this->data = inlineData;
+  this->capacity = N;
+  this->count = 0;
+}
+
+template <class T, int N>
+XSmallList<T, N>::XSmallList(const XSmallList<T, N> &list) {
+  this->data = inlineData;
+  this->capacity = N;
+  this->count = 0;
+  copyFrom(list);
+}
+
+template <class T, int N>
+XSmallList<T, N> &XSmallList<T, N>::operator=(const XSmallList<T, N> &list) {
+  if (this == &list) return *this;
+  removeInternalData();
+  copyFrom(list);
+  return *this;
+}
+
+template <class T, int N>
+XSmallList<T, N>::~XSmallList() {
+  removeInternalData();
+}
+
+template <class T, int N>
+void XSmallList<T, N>::add(T e) {
+  ensureCapacity(count + 1);
+  data[count++] = e;
+}
+
+template <class T, int N>
+void XSmallList<T, N>::add(int index, T e) {
+  if (index < 0 || index > count) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  ensureCapacity(count + 1);
+  for (int i = count; i > index; i--) {
+    data[i] = std::move(data[i - 1]);
+  }
+  data[index] = e;
+  count++;
+}
+
+template <class T, int N>
+T XSmallList<T, N>::removeAt(int index) {
+  if (index < 0 || index >= count) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  T removedItem = data[index];
+  for (int i = index; i < count - 1; i++) {
+    data[i] = std::move(data[i + 1]);
+  }
+  count--;
+  return removedItem;
+}
+
+template <class T, int N>
+bool XSmallList<T, N>::removeItem(T item, void (*removeItemData)(T)) {
+  for (int i = 0; i < count; i++) {
+    if (equals(data[i], item, itemEqual)) {
+      if (removeItemData != nullptr) {
+        removeItemData(data[i]);
+      }
+      removeAt(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class T, int N>
+bool XSmallList<T, N>::empty() {
+  return count == 0;
+}
+
+template <class T, int N>
+int XSmallList<T, N>::size() {
+  return count;
+}
+
+template <class T, int N>
+void XSmallList<T, N>::clear() {
+  removeInternalData();
+  if constexpr (!std::is_trivially_destructible<T>::value) {
+    for (int i = 0; i < N; i++) {
+      inlineData[i] = T();  // release what the inline slots still own
+    }
+  }
+}
+
+template <class T, int N>
+T &XSmallList<T, N>::get(int index) {
+  if (index < 0 || index >= count) {
+    throw std::out_of_range("Index is out of range!");
+  }
+  return data[index];
+}
+
+template <class T, int N>
+int XSmallList<T, N>::indexOf(T item) {
+  for (int i = 0; i < count; i++) {
+    if (equals(data[i], item, itemEqual)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+template <class T, int N>
+bool XSmallList<T, N>::contains(T item) {
+  return indexOf(item) != -1;
+}
+
+template <class T, int N>
+string XSmallList<T, N>::toString(string (*item2str)(T &)) {
+  stringstream ss;
+  ss << "[";
+  for (int i = 0; i < count; i++) {
+    if (item2str) {
+      ss << item2str(data[i]);
+    } else if constexpr (std::is_pointer_v<T>) {
+      ss << *data[i];
+    } else {
+      ss << data[i];
+    }
+    if (i < count - 1) ss << ", ";
+  }
+  ss << "]";
+  return ss.str();
+}
+
+template <class T, int N>
+void XSmallList<T, N>::reserve(int minCapacity) {
+  if (minCapacity > capacity) moveStorage(minCapacity);
+}
+
+template <class T, int N>
+void XSmallList<T, N>::shrink_to_fit() {
+  if (isInline()) return;
+  int newCapacity = (count <= N) ? N : count;
+  if (newCapacity < capacity) moveStorage(newCapacity);
+}
+
+template <class T, int N>
+void XSmallList<T, N>::ensureCapacity(int minCapacity) {
+  if (minCapacity > capacity) {
+    moveStorage(max(2 * capacity, minCapacity));
+  }
+}
+
+template <class T, int N>
+void XSmallList<T, N>::moveStorage(int newCapacity) {
+  // newCapacity == N means "back to the inline slots"
+  T *newData = inlineData;
+  if (newCapacity != N) {
+    ALLOC_TAG(ALLOC_XARRAYLIST);
+    newData = new T[newCapacity];
+  }
+  if (newData != data) {
+    for (int i = 0; i < count; i++) {
+      newData[i] = std::move(data[i]);
+    }
+    if (data != inlineData) delete[] data;
+  }
+  data = newData;
+  capacity = newCapacity;
+}
+
+template <class T, int N>
+void XSmallList<T, N>::copyFrom(const XSmallList<T, N> &list) {
+  this->itemEqual = list.itemEqual;
+  this->deleteUserData = list.deleteUserData;
+  reserve(list.count);
+  for (int i = 0; i < list.count; i++) {
+    this->data[i] = list.data[i];
+  }
+  this->count = list.count;
+}
+
+template <class T, int N>
+void XSmallList<T, N>::removeInternalData() {
+  if (deleteUserData != nullptr) {
+    deleteUserData(this);
+  }
+  if (data != inlineData) delete[] data;
+  data = inlineData;
+  capacity = N;
+  count = 0;
+}
+
+#endif /* XSMALLLIST_H */
@@ -0,0 +1,130 @@
+/*
+ * File:   AllocTracker.h
+ *
+ * Opt-in heap allocation accounting, compiled in with -DALLOC_TRACKING
+ * (CMake: -DANN_ALLOC_TRACKING=ON).
+ *
+ * When enabled, AllocTracker.cpp replaces the global operator new/delete and
+ * charges every allocation to the calling thread's current subsystem. Code
+ * marks its allocations with ALLOC_TAG(subsystem) for the rest of the scope;
+ * anything untagged is charged to ALLOC_OTHER. Without ALLOC_TRACKING the
+ * tags compile to nothing and all counters stay at zero.
+ *
+ *   AllocRegion region("predict");
+ *   model.predict(X);
+ *   region.println();      //allocations / bytes / peak live, per subsystem
+ */
+
+#ifndef ALLOCTRACKER_H
+#define ALLOCTRACKER_H
+#include <cstddef>
+#include <iostream>
+#include <string>
+using namespace std;
+
+enum alloc_subsystem {
+    ALLOC_OTHER = 0,        //untagged allocations
+    ALLOC_XARRAYLIST,
+    ALLOC_DLINKEDLIST,
+    ALLOC_XDEQUE,
+    ALLOC_ANN,              //tensors created by layers and models
+    ALLOC_DATA,             //datasets and data loaders
+    ALLOC_NUM_SUBSYSTEMS
+};
+
+struct AllocStats {
+    unsigned long long allocations;
+    unsigned long long deallocations;
+    unsigned long long bytes_allocated;     //cumulative
+    long long live_bytes;                   //allocated but not yet freed
+    long long peak_bytes;                   //high-water mark of live_bytes
+};
+
+class AllocTracker {
+public:
+    /* enabled(): true if the library was built with ALLOC_TRACKING
+     */
+    static bool enabled();
+    
+    /* record_alloc/record_free: charge a block to "subsystem"; called by the
+     *      global operator new/delete, and directly by code that bypasses them
+     *      (e.g. malloc/realloc based storage)
+     */
+    static void record_alloc(int subsystem, size_t bytes);
+    static void record_free(int subsystem, size_t bytes);
+    
+    /* stats(subsystem): counters since start-up or the last reset();
+     *      subsystem == ALLOC_NUM_SUBSYSTEMS gives the total over all of them
+     */
+    static AllocStats stats(int subsystem);
+    static AllocStats total(){ return stats(ALLOC_NUM_SUBSYSTEMS); }
+    /* reset(): zero the counters; live bytes are kept so that frees of
+     *      blocks allocated before the reset still balance
+     */
+    static void reset();
+    
+    /* current/set_current: the calling thread's subsystem tag;
+     *      set_current returns the previous tag
+     */
+    static int current();
+    static int set_current(int subsystem);
+    static string name(int subsystem);
+    
+    static string toTable();
+    static void println(){ cout << toTable() << endl; }
+    
+private:
+    friend class AllocRegion;
+    static long long begin_peak(int subsystem);
+    static void end_peak(int subsystem, long long outer_peak);
+};
+
+/* AllocTag: charge allocations in the enclosing scope to "subsystem"
+ */
+class AllocTag {
+public:
+    AllocTag(int subsystem): m_nPrevious(AllocTracker::set_current(subsystem)) {}
+    ~AllocTag(){ AllocTracker::set_current(m_nPrevious); }
+private:
+    AllocTag(const AllocTag& orig);
+    AllocTag& operator=(const AllocTag& orig);
+    int m_nPrevious;
+};
+
+#ifdef ALLOC_TRACKING
+#define ALLOC_TAG_CONCAT_(a, b) a##b
+#define ALLOC_TAG_CONCAT(a, b) ALLOC_TAG_CONCAT_(a, b)
+#define ALLOC_TAG(subsystem) AllocTag ALLOC_TAG_CONCAT(alloc_tag_, __LINE__)(subsystem)
+#else
+#define ALLOC_TAG(subsystem) ((void)0)
+#endif
+
+/* AllocRegion: counters for the lifetime of a scope.
+ *   >> delta(subsystem) reports what happened since construction; peak_bytes
+ *      is the rise of the high-water mark above the live bytes at the start.
+ *   >> counters are process-wide, so allocations made by other threads while
+ *      the region is open are included.
+ *   >> regions may nest; the outer region still sees the inner peak.
+ */
+class AllocRegion {
+public:
+    AllocRegion(string name="");
+    ~AllocRegion();
+    
+    AllocStats delta(int subsystem);
+    AllocStats total(){ return delta(ALLOC_NUM_SUBSYSTEMS); }
+    string getname(){ return m_sName; }
+    
+    string toString();
+    void println(){ cout << toString() << endl; }
+    
+private:
+    AllocRegion(const AllocRegion& orig);
+    AllocRegion& operator=(const AllocRegion& orig);
+    
+    string m_sName;
+    AllocStats m_aStart[ALLOC_NUM_SUBSYSTEMS + 1];
+    long long m_aOuterPeak[ALLOC_NUM_SUBSYSTEMS + 1];
+};
+
+#endif /* ALLOCTRACKER_H */
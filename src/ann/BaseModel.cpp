@@ -12,23 +12,289 @@
 
 #include "ann/BaseModel.h"
 #include "ann/xtensor_lib.h"
+#include "ann/checkpoint.h"
+#include "ann/FCLayer.h"
+#include "ann/ReLU.h"
+#include "ann/Softmax.h"
+#include "util/AllocTracker.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
 
 
-BaseModel::BaseModel() {
-    /*TODO: Your code is here*/ 
+BaseModel::BaseModel(): m_pProfiler(nullptr) {
 }
-BaseModel::BaseModel(Layer** seq, int size) {
-    /*TODO: Your code is here*/ 
+BaseModel::BaseModel(Layer** seq, int size): m_pProfiler(nullptr) {
+    for(int idx=0; idx < size; idx++) layers.add(seq[idx]);
 }
 
-BaseModel::BaseModel(const BaseModel& orig) {
+BaseModel::BaseModel(const BaseModel& orig): m_pProfiler(nullptr) {
     /*TODO: Your code is here*/ 
 }
 
 BaseModel::~BaseModel() {
     for(auto ptr_layer: layers) delete ptr_layer;
+    delete m_pProfiler.load();
+    for(ModelProfiler* retired: m_retiredProfilers) delete retired;
 }
 
 xt::xarray<double> BaseModel::predict(xt::xarray<double> X){
-    /*TODO: Your code is here*/ 
+    ALLOC_TAG(ALLOC_ANN);
+    ModelProfiler* profiler = m_pProfiler.load(std::memory_order_acquire);
+    if(profiler != nullptr) return predict_profiled(X, *profiler);
+    for(auto ptr_layer: layers) X = ptr_layer->forward(X);
+    return X;
+}
+
+const xt::xarray<double>& BaseModel::predict(const xt::xarray<double>& X, InferenceContext& ctx){
+    ALLOC_TAG(ALLOC_ANN);
+    ModelProfiler* profiler = m_pProfiler.load(std::memory_order_acquire);
+    if(profiler != nullptr) return predict_profiled(X, ctx, *profiler);
+    ctx.reserve(layers.size() + 1);
+    const xt::xarray<double>* input = &X;
+    int slot = 0;
+    for(auto ptr_layer: layers){
+        xt::xarray<double>& output = ctx.scratch(slot++);
+        ptr_layer->infer(*input, output);
+        input = &output;
+    }
+    if(slot == 0){
+        ctx.scratch(0) = X;
+        return ctx.scratch(0);
+    }
+    return *input;
+}
+
+xt::xarray<double> BaseModel::predict(const CSRMatrix& X){
+    ALLOC_TAG(ALLOC_ANN);
+    if(layers.empty()) return X.toDense();
+    FCLayer* first = dynamic_cast<FCLayer*>(layers.get(0));
+    if(first == nullptr) return predict(X.toDense());
+    
+    xt::xarray<double> Y = first->forward(X);
+    bool skip = true;
+    for(auto ptr_layer: layers){
+        if(skip){ skip = false; continue; }
+        Y = ptr_layer->forward(Y);
+    }
+    return Y;
+}
+
+void BaseModel::enable_profiling(bool enable){
+    std::lock_guard<std::mutex> lock(m_profilingMutex);
+    ModelProfiler* current = m_pProfiler.load(std::memory_order_relaxed);
+    //keep the statistics collected so far if profiling is already on
+    if(enable == (current != nullptr)) return;
+    if(enable){
+        m_pProfiler.store(new ModelProfiler(), std::memory_order_release);
+        return;
+    }
+    //a predict that already loaded "current" may still record into it
+    m_pProfiler.store(nullptr, std::memory_order_release);
+    m_retiredProfilers.push_back(current);
+}
+
+static double elapsed_seconds(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+xt::xarray<double> BaseModel::predict_profiled(xt::xarray<double> X, ModelProfiler& profiler){
+    int position = 0;
+    for(auto ptr_layer: layers){
+        double flops = ptr_layer->flop_count(X);
+        auto start = std::chrono::steady_clock::now();
+        xt::xarray<double> Y = ptr_layer->forward(X);
+        double seconds = elapsed_seconds(start);
+        //forward always returns a freshly allocated tensor
+        profiler.record(position++, ptr_layer->getname(), X, Y, seconds,
+                            Y.size()*sizeof(double), flops);
+        X = std::move(Y);
+    }
+    return X;
+}
+
+const xt::xarray<double>& BaseModel::predict_profiled(const xt::xarray<double>& X, InferenceContext& ctx,
+                                                      ModelProfiler& profiler){
+    ctx.reserve(layers.size() + 1);
+    const xt::xarray<double>* input = &X;
+    int slot = 0;
+    for(auto ptr_layer: layers){
+        xt::xarray<double>& output = ctx.scratch(slot);
+        const double* old_data = output.data();
+        double flops = ptr_layer->flop_count(*input);
+        auto start = std::chrono::steady_clock::now();
+        ptr_layer->infer(*input, output);
+        double seconds = elapsed_seconds(start);
+        //infer only allocates when the scratch buffer had to be replaced
+        unsigned long long bytes = (output.data() != old_data)? output.size()*sizeof(double) : 0;
+        profiler.record(slot++, ptr_layer->getname(), *input, output, seconds, bytes, flops);
+        input = &output;
+    }
+    if(slot == 0){
+        ctx.scratch(0) = X;
+        return ctx.scratch(0);
+    }
+    return *input;
+}
+
+void BaseModel::train(){
+    for(auto ptr_layer: layers) ptr_layer->set_training(true);
+}
+
+void BaseModel::eval(){
+    for(auto ptr_layer: layers) ptr_layer->set_training(false);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Checkpoint save/load
+////////////////////////////////////////////////////////////////////////
+static void write_padding(ofstream& os, uint64_t& offset, uint64_t target){
+    static const char zeros[CHECKPOINT_ALIGNMENT] = {0};
+    while(offset < target){
+        uint64_t n = std::min<uint64_t>(target - offset, CHECKPOINT_ALIGNMENT);
+        os.write(zeros, n);
+        offset += n;
+    }
+}
+
+void BaseModel::save(string filename){
+    int nlayers = layers.size();
+    CheckpointLayerRecord* records = new CheckpointLayerRecord[nlayers];
+    memset(records, 0, sizeof(CheckpointLayerRecord)*nlayers);
+    
+    //pass 1: lay out the records and the payload offsets
+    uint64_t offset = sizeof(CheckpointHeader) + sizeof(CheckpointLayerRecord)*nlayers;
+    int idx = 0;
+    for(auto ptr_layer: layers){
+        CheckpointLayerRecord& rec = records[idx++];
+        if(FCLayer* fc = dynamic_cast<FCLayer*>(ptr_layer)){
+            rec.kind = CKPT_LAYER_FC;
+            rec.flags = fc->get_use_bias()? CKPT_FLAG_USE_BIAS : 0;
+            rec.in_features = fc->get_in_features();
+            rec.out_features = fc->get_out_features();
+            offset = checkpoint_align(offset);
+            rec.weight_offset = offset;
+            offset += sizeof(double)*(uint64_t)rec.in_features*rec.out_features;
+            if(fc->get_use_bias()){
+                offset = checkpoint_align(offset);
+                rec.bias_offset = offset;
+                offset += sizeof(double)*(uint64_t)rec.out_features;
+            }
+        }
+        else if(dynamic_cast<ReLU*>(ptr_layer) != nullptr){
+            rec.kind = CKPT_LAYER_RELU;
+        }
+        else if(Softmax* sm = dynamic_cast<Softmax*>(ptr_layer)){
+            rec.kind = CKPT_LAYER_SOFTMAX;
+            rec.axis = sm->get_axis();
+        }
+        else{
+            delete []records;
+            throw std::runtime_error("BaseModel::save: unsupported layer " + ptr_layer->getname());
+        }
+    }
+    
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.endian_tag = CHECKPOINT_ENDIAN_TAG;
+    header.num_layers = nlayers;
+    header.file_size = offset;
+    
+    //pass 2: write everything out in order
+    ofstream os(filename, ios::binary | ios::trunc);
+    if(!os.is_open()){
+        delete []records;
+        throw std::runtime_error("BaseModel::save: cannot open " + filename);
+    }
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char*>(records), sizeof(CheckpointLayerRecord)*nlayers);
+    offset = sizeof(CheckpointHeader) + sizeof(CheckpointLayerRecord)*nlayers;
+    idx = 0;
+    for(auto ptr_layer: layers){
+        CheckpointLayerRecord& rec = records[idx++];
+        if(rec.kind != CKPT_LAYER_FC) continue;
+        FCLayer* fc = dynamic_cast<FCLayer*>(ptr_layer);
+        uint64_t nbytes = sizeof(double)*(uint64_t)rec.in_features*rec.out_features;
+        write_padding(os, offset, rec.weight_offset);
+        os.write(reinterpret_cast<const char*>(fc->weights_data()), nbytes);
+        offset += nbytes;
+        if(rec.bias_offset != 0){
+            nbytes = sizeof(double)*(uint64_t)rec.out_features;
+            write_padding(os, offset, rec.bias_offset);
+            os.write(reinterpret_cast<const char*>(fc->bias_data()), nbytes);
+            offset += nbytes;
+        }
+    }
+    delete []records;
+    os.close();
+    if(!os) throw std::runtime_error("BaseModel::save: failed writing " + filename);
+}
+
+BaseModel* BaseModel::load(string filename){
+    shared_ptr<MappedFile> mapping = make_shared<MappedFile>(filename);
+    char* base = mapping->data();
+    uint64_t fsize = mapping->size();
+    
+    if(fsize < sizeof(CheckpointHeader))
+        throw std::runtime_error("BaseModel::load: " + filename + " is too small");
+    const CheckpointHeader* header = reinterpret_cast<const CheckpointHeader*>(base);
+    if(memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0)
+        throw std::runtime_error("BaseModel::load: " + filename + " is not a checkpoint");
+    if(header->endian_tag != CHECKPOINT_ENDIAN_TAG)
+        throw std::runtime_error("BaseModel::load: " + filename + " has foreign byte order");
+    if(header->version != CHECKPOINT_VERSION)
+        throw std::runtime_error("BaseModel::load: unsupported checkpoint version "
+                + to_string(header->version));
+    uint64_t table_end = sizeof(CheckpointHeader)
+            + sizeof(CheckpointLayerRecord)*(uint64_t)header->num_layers;
+    if(header->file_size != fsize || table_end > fsize)
+        throw std::runtime_error("BaseModel::load: " + filename + " is truncated");
+    
+    const CheckpointLayerRecord* records =
+            reinterpret_cast<const CheckpointLayerRecord*>(base + sizeof(CheckpointHeader));
+    BaseModel* model = new BaseModel();
+    try{
+        for(uint32_t idx=0; idx < header->num_layers; idx++){
+            const CheckpointLayerRecord& rec = records[idx];
+            switch(rec.kind){
+                case CKPT_LAYER_FC: {
+                    bool use_bias = (rec.flags & CKPT_FLAG_USE_BIAS) != 0;
+                    //sizes are compared as "bytes > fsize - offset" so nothing can wrap around
+                    uint64_t max_doubles = fsize/sizeof(double);
+                    bool sizes_ok = rec.in_features > 0 && rec.out_features > 0
+                            && (uint64_t)rec.in_features <= max_doubles/(uint64_t)rec.out_features;
+                    uint64_t wbytes = sizes_ok? sizeof(double)*(uint64_t)rec.in_features*rec.out_features : 0;
+                    uint64_t bbytes = sizes_ok? sizeof(double)*(uint64_t)rec.out_features : 0;
+                    if(!sizes_ok
+                            || rec.weight_offset % CHECKPOINT_ALIGNMENT != 0
+                            || rec.weight_offset < table_end || rec.weight_offset > fsize - wbytes
+                            || (use_bias && (rec.bias_offset % CHECKPOINT_ALIGNMENT != 0
+                                || rec.bias_offset < table_end || rec.bias_offset > fsize - bbytes)))
+                        throw std::runtime_error("BaseModel::load: corrupt FC record "
+                                + to_string(idx) + " in " + filename);
+                    double* weights = reinterpret_cast<double*>(base + rec.weight_offset);
+                    double* bias = use_bias? reinterpret_cast<double*>(base + rec.bias_offset) : nullptr;
+                    model->layers.add(FCLayer::fromMapped(rec.in_features, rec.out_features,
+                                                          use_bias, mapping, weights, bias));
+                    break;
+                }
+                case CKPT_LAYER_RELU:
+                    model->layers.add(new ReLU());
+                    break;
+                case CKPT_LAYER_SOFTMAX:
+                    model->layers.add(new Softmax(rec.axis));
+                    break;
+                default:
+                    throw std::runtime_error("BaseModel::load: unknown layer kind "
+                            + to_string(rec.kind) + " in " + filename);
+            }
+        }
+    }
+    catch(...){
+        delete model;
+        throw;
+    }
+    return model;
 }
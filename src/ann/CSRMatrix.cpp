@@ -0,0 +1,72 @@
+/*
+ * File:   CSRMatrix.cpp
+ */
+
+#include "ann/CSRMatrix.h"
+#include <limits>
+
+CSRMatrix::CSRMatrix(size_t cols): m_nCols(cols) {
+    m_rowPtr.push_back(0);
+}
+
+CSRMatrix CSRMatrix::fromDense(const xt::xarray<double>& X, double tol){
+    if(X.dimension() != 2)
+        throw std::invalid_argument("CSRMatrix::fromDense: expected a 2-D array, got "
+                + shape2str(X.shape()));
+    size_t nrows = X.shape()[0], ncols = X.shape()[1];
+    CSRMatrix csr(ncols);
+    const double* px = X.data();
+    vector<index_t> cols;
+    vector<double> values;
+    for(size_t r=0; r < nrows; r++){
+        cols.clear();
+        values.clear();
+        for(size_t c=0; c < ncols; c++){
+            double v = px[r*ncols + c];
+            if(std::abs(v) > tol){
+                cols.push_back(c);
+                values.push_back(v);
+            }
+        }
+        csr.append_row(cols.data(), values.data(), cols.size());
+    }
+    return csr;
+}
+
+xt::xarray<double> CSRMatrix::toDense() const {
+    xt::xarray<double> X = xt::zeros<double>({rows(), cols()});
+    double* px = X.data();
+    for(size_t r=0; r < rows(); r++)
+        for(index_t k=m_rowPtr[r]; k < m_rowPtr[r + 1]; k++)
+            px[r*m_nCols + m_colIdx[k]] = m_values[k];
+    return X;
+}
+
+void CSRMatrix::append_row(const index_t* cols, const double* values, size_t n){
+    if(nnz() + n > (size_t)std::numeric_limits<index_t>::max())
+        throw std::length_error("CSRMatrix: too many non-zeros for the index type");
+    for(size_t k=0; k < n; k++){
+        if(cols[k] < 0 || (size_t)cols[k] >= m_nCols)
+            throw std::out_of_range("CSRMatrix: column index is out of range!");
+    }
+    m_colIdx.insert(m_colIdx.end(), cols, cols + n);
+    m_values.insert(m_values.end(), values, values + n);
+    m_rowPtr.push_back(m_values.size());
+}
+
+void CSRMatrix::append_rows(const CSRMatrix& other, const size_t* rows, size_t n){
+    if(other.m_nCols != m_nCols)
+        throw std::invalid_argument("CSRMatrix::append_rows: column counts differ");
+    for(size_t idx=0; idx < n; idx++){
+        size_t r = rows[idx];
+        if(r >= other.rows()) throw std::out_of_range("CSRMatrix: row index is out of range!");
+        index_t begin = other.m_rowPtr[r], end = other.m_rowPtr[r + 1];
+        append_row(other.m_colIdx.data() + begin, other.m_values.data() + begin, end - begin);
+    }
+}
+
+void CSRMatrix::reserve(size_t rows, size_t nnz){
+    m_rowPtr.reserve(rows + 1);
+    m_colIdx.reserve(nnz);
+    m_values.reserve(nnz);
+}
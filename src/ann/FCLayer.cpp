@@ -11,6 +11,7 @@
  */
 
 #include "ann/FCLayer.h"
+#include "ann/BaseModel.h"
 #include "ann/funtions.h"
 
 FCLayer::FCLayer(int in_features, int out_features, bool use_bias) {
@@ -19,15 +20,42 @@ FCLayer::FCLayer(int in_features, int out_features, bool use_bias) {
     this->m_bUse_Bias = use_bias;
     name = "FC_" + to_string(++layer_idx);
     m_unSample_Counter = 0;
+    m_pMappedW = nullptr;
+    m_pMappedB = nullptr;
     
     init_weights();
 }
+
+FCLayer::FCLayer(int in_features, int out_features, bool use_bias,
+                 shared_ptr<MappedFile> mapping, double* weights, double* bias) {
+    this->m_nIn_Features = in_features;
+    this->m_nOut_Features = out_features;
+    this->m_bUse_Bias = use_bias;
+    name = "FC_" + to_string(++layer_idx);
+    m_unSample_Counter = 0;
+    m_pMapping = mapping;
+    m_pMappedW = weights;
+    m_pMappedB = use_bias? bias : nullptr;
+}
+
 void FCLayer::init_weights(){
-   /*TODO: Your code is here*/
+    //Xavier/Glorot normal initialization
+    double std_dev = std::sqrt(2.0/(m_nIn_Features + m_nOut_Features));
+    m_aWeights = xt::random::randn<double>({m_nOut_Features, m_nIn_Features}, 0.0, std_dev);
+    if(m_bUse_Bias) m_aBias = xt::zeros<double>({m_nOut_Features});
 }
 
 FCLayer::FCLayer(const FCLayer& orig) {
     name = "FC_" + to_string(++layer_idx);
+    m_nIn_Features = orig.m_nIn_Features;
+    m_nOut_Features = orig.m_nOut_Features;
+    m_bUse_Bias = orig.m_bUse_Bias;
+    m_aWeights = orig.m_aWeights;
+    m_aBias = orig.m_aBias;
+    m_unSample_Counter = 0;
+    m_pMapping = orig.m_pMapping; //mapped weights are read-only, safe to share
+    m_pMappedW = orig.m_pMappedW;
+    m_pMappedB = orig.m_pMappedB;
 }
 
 FCLayer::~FCLayer() {
@@ -35,9 +63,89 @@ FCLayer::~FCLayer() {
 }
 
 xt::xarray<double> FCLayer::forward(xt::xarray<double> X) {
-    /*TODO: Your code is here*/ 
+    if(is_training) m_aCached_X = X;
+    xt::xarray<double> Y;
+    affine(X, Y);
+    return Y;
 }
 
-static FCLayer* FCLayer::fromPretrained(string filename, bool use_bias){
-    /*TODO: Your code is here*/ 
+void FCLayer::infer(const xt::xarray<double>& X, xt::xarray<double>& Y) {
+    affine(X, Y);
+}
+
+xt::xarray<double> FCLayer::forward(const CSRMatrix& X) {
+    if(X.cols() != (size_t)m_nIn_Features)
+        throw std::invalid_argument("FCLayer::forward: expected input of shape (N, "
+                + to_string(m_nIn_Features) + "), got " + shape2str(X.shape()));
+    typedef CSRMatrix::index_t index_t;
+    index_t nsamples = X.rows(), n_in = m_nIn_Features, n_out = m_nOut_Features;
+    
+    //gecrsmm works column-major: C(:, j) = X * B(:, j). Column j of W^T is
+    //row j of W (contiguous), and column j of C is row j of Y^T.
+    xt::xarray<double> YT = xt::empty<double>({(size_t)n_out, (size_t)nsamples});
+    if(nsamples > 0)
+        cxxblas::gecrsmm<index_t>(cxxblas::Transpose::NoTrans, nsamples, n_out, n_in,
+                1.0, X.values(), X.row_ptr(), X.col_idx(),
+                weights_data(), n_in,
+                0.0, YT.data(), nsamples);
+    xt::xarray<double> Y = xt::transpose(YT);
+    if(m_bUse_Bias){
+        auto b = xt::adapt(const_cast<double*>(bias_data()), (size_t)n_out, xt::no_ownership(),
+                           std::vector<size_t>{(size_t)n_out});
+        Y += b;
+    }
+    return Y;
+}
+
+double FCLayer::flop_count(const xt::xarray<double>& X) {
+    double nsamples = (X.dimension() <= 1)? 1 : X.shape()[0];
+    double per_sample = 2.0*m_nIn_Features*m_nOut_Features + (m_bUse_Bias? m_nOut_Features : 0);
+    return nsamples*per_sample;
+}
+
+void FCLayer::affine(const xt::xarray<double>& X, xt::xarray<double>& Y) {
+    //X: (N, in_features) or (in_features); W: (out_features, in_features)
+    bool is_vector = (X.dimension() == 1);
+    if((X.dimension() != 1 && X.dimension() != 2)
+            || X.shape()[X.dimension() - 1] != (size_t)m_nIn_Features)
+        throw std::invalid_argument("FCLayer::forward: expected input of shape (N, "
+                + to_string(m_nIn_Features) + "), got " + shape2str(X.shape()));
+    
+    size_t nsamples = is_vector? 1 : X.shape()[0];
+    size_t n_in = m_nIn_Features, n_out = m_nOut_Features;
+    auto X2 = xt::adapt(const_cast<double*>(X.data()), nsamples*n_in, xt::no_ownership(),
+                        std::vector<size_t>{nsamples, n_in});
+    auto W = xt::adapt(const_cast<double*>(weights_data()), n_out*n_in, xt::no_ownership(),
+                       std::vector<size_t>{n_out, n_in});
+    if(Y.dimension() != 2 || Y.shape()[0] != nsamples || Y.shape()[1] != n_out)
+        Y.resize({nsamples, n_out});
+    xt::blas::gemm(X2, W, Y, false, true); //Y = X * W^T
+    if(m_bUse_Bias){
+        auto b = xt::adapt(const_cast<double*>(bias_data()), n_out, xt::no_ownership(),
+                           std::vector<size_t>{n_out});
+        Y += b;
+    }
+    if(is_vector) Y.reshape({n_out});
+}
+
+FCLayer* FCLayer::fromPretrained(string filename, bool use_bias){
+    BaseModel* model = BaseModel::load(filename);
+    FCLayer* source = nullptr;
+    for(int idx=0; idx < model->num_layers() && source == nullptr; idx++)
+        source = dynamic_cast<FCLayer*>(model->get_layer(idx));
+    if(source == nullptr || (use_bias && !source->m_bUse_Bias)){
+        delete model;
+        throw std::runtime_error("FCLayer::fromPretrained: " + filename + " has no FC layer"
+                + (use_bias? " with bias" : ""));
+    }
+    //share the mapping: the new layer keeps it alive after the model is gone
+    FCLayer* layer = fromMapped(source->m_nIn_Features, source->m_nOut_Features, use_bias,
+                                source->m_pMapping, source->m_pMappedW, source->m_pMappedB);
+    delete model;
+    return layer;
+}
+
+FCLayer* FCLayer::fromMapped(int in_features, int out_features, bool use_bias,
+                             shared_ptr<MappedFile> mapping, double* weights, double* bias){
+    return new FCLayer(in_features, out_features, use_bias, mapping, weights, bias);
 }
\ No newline at end of file
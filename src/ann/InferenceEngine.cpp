@@ -0,0 +1,181 @@
+/*
+ * File:   InferenceEngine.cpp
+ */
+
+#include "ann/InferenceEngine.h"
+#include "util/AllocTracker.h"
+#include <algorithm>
+#include <stdexcept>
+
+InferenceEngine::InferenceEngine(BaseModel* model, InferenceConfig config):
+        m_pModel(model), m_config(config), m_bStopping(false), m_bHasShape(false),
+        m_nLatencyNext(0), m_nRequests(0), m_nBatches(0) {
+    if(model == nullptr)
+        throw std::invalid_argument("InferenceEngine: model must not be null");
+    if(m_config.max_batch_size < 1) m_config.max_batch_size = 1;
+    if(m_config.queue_depth < 1) m_config.queue_depth = 1;
+    if(m_config.max_latency_us < 0) m_config.max_latency_us = 0;
+    if(m_config.latency_window < 1) m_config.latency_window = 1;
+    if(!m_config.sample_shape.empty()){
+        m_sampleShape.assign(m_config.sample_shape.begin(), m_config.sample_shape.end());
+        m_bHasShape = true;
+    }
+    m_latencies.reserve(m_config.latency_window);
+    m_worker = std::thread(&InferenceEngine::worker_loop, this);
+}
+
+InferenceEngine::~InferenceEngine() {
+    stop();
+}
+
+std::future<xt::xarray<double>> InferenceEngine::submit(xt::xarray<double> sample){
+    std::unique_lock<std::mutex> lock(m_mutex);
+    check_shape(sample);
+    m_cvNotFull.wait(lock, [this]{
+        return m_bStopping || m_queue.size() < m_config.queue_depth;
+    });
+    if(m_bStopping) throw std::runtime_error("InferenceEngine: engine is stopped");
+    return enqueue(sample);
+}
+
+bool InferenceEngine::try_submit(xt::xarray<double> sample, std::future<xt::xarray<double>>& result){
+    std::unique_lock<std::mutex> lock(m_mutex);
+    check_shape(sample);
+    if(m_bStopping || m_queue.size() >= m_config.queue_depth) return false;
+    result = enqueue(sample);
+    return true;
+}
+
+//caller holds m_mutex; the first accepted sample fixes the shape unless configured
+void InferenceEngine::check_shape(const xt::xarray<double>& sample){
+    xt::svector<unsigned long> shape(sample.shape().begin(), sample.shape().end());
+    if(!m_bHasShape){
+        m_sampleShape = shape;
+        m_bHasShape = true;
+    }
+    else if(!(shape == m_sampleShape))
+        throw std::invalid_argument("InferenceEngine: sample shape " + shape2str(shape)
+                + " does not match " + shape2str(m_sampleShape));
+}
+
+//caller holds m_mutex
+std::future<xt::xarray<double>> InferenceEngine::enqueue(xt::xarray<double>& sample){
+    Request* req = new Request();
+    req->sample = std::move(sample);
+    req->enqueued = clock::now();
+    std::future<xt::xarray<double>> result = req->promise.get_future();
+    m_queue.add(req);
+    m_cvNotEmpty.notify_one();
+    return result;
+}
+
+void InferenceEngine::stop(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStopping = true;
+    }
+    m_cvNotEmpty.notify_all();
+    m_cvNotFull.notify_all();
+    if(m_worker.joinable()) m_worker.join();
+}
+
+void InferenceEngine::worker_loop(){
+    vector<Request*> batch;
+    batch.reserve(m_config.max_batch_size);
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cvNotEmpty.wait(lock, [this]{ return m_bStopping || !m_queue.empty(); });
+            if(m_queue.empty()) return; //stopping and fully drained
+            
+            //give the oldest request up to max_latency_us to gather a full batch
+            clock::time_point deadline = m_queue.get(0)->enqueued
+                    + std::chrono::microseconds(m_config.max_latency_us);
+            m_cvNotEmpty.wait_until(lock, deadline, [this]{
+                return m_bStopping || m_queue.size() >= m_config.max_batch_size;
+            });
+            while(!m_queue.empty() && (int)batch.size() < m_config.max_batch_size)
+                batch.push_back(m_queue.removeAt(0));
+        }
+        m_cvNotFull.notify_all();
+        run_batch(batch);
+        batch.clear();
+    }
+}
+
+void InferenceEngine::run_batch(vector<Request*>& batch){
+    ALLOC_TAG(ALLOC_ANN);
+    xt::xarray<double> Y;
+    std::exception_ptr error;
+    try{
+        //gather: (batch, *sample_shape); submit already checked every sample's shape
+        xt::svector<unsigned long> shape = batch[0]->sample.shape();
+        size_t sample_size = batch[0]->sample.size();
+        shape.insert(shape.begin(), batch.size());
+        xt::xarray<double> X = xt::empty<double>(shape);
+        for(size_t idx=0; idx < batch.size(); idx++){
+            xt::xarray<double>& sample = batch[idx]->sample;
+            std::copy(sample.data(), sample.data() + sample_size, X.data() + idx*sample_size);
+        }
+        Y = m_pModel->predict(X);
+        if(Y.dimension() == 0 || Y.shape()[0] != batch.size())
+            throw std::runtime_error("InferenceEngine: predict returned " + shape2str(Y.shape())
+                    + " for a batch of " + to_string(batch.size()));
+    }
+    catch(...){
+        error = std::current_exception();
+    }
+    
+    //account first, so stats() already covers a request once its future is ready
+    clock::time_point done = clock::now();
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        for(Request* req: batch)
+            record_latency(std::chrono::duration<double, std::micro>(done - req->enqueued).count());
+        m_nRequests += batch.size();
+        m_nBatches += 1;
+    }
+    
+    //scatter
+    for(size_t idx=0; idx < batch.size(); idx++){
+        if(error) batch[idx]->promise.set_exception(error);
+        else{
+            xt::xarray<double> row = xt::view(Y, idx);
+            batch[idx]->promise.set_value(std::move(row));
+        }
+        delete batch[idx];
+    }
+}
+
+//caller holds m_statsMutex
+void InferenceEngine::record_latency(double latency_us){
+    if((int)m_latencies.size() < m_config.latency_window) m_latencies.push_back(latency_us);
+    else m_latencies[m_nLatencyNext] = latency_us;
+    m_nLatencyNext = (m_nLatencyNext + 1) % m_config.latency_window;
+}
+
+static double percentile(vector<double>& values, double q){
+    if(values.empty()) return 0;
+    size_t k = static_cast<size_t>(q*(values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+InferenceStats InferenceEngine::stats(){
+    InferenceStats st;
+    vector<double> window;
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        window = m_latencies;
+        st.requests = m_nRequests;
+        st.batches = m_nBatches;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        st.queued = m_queue.size();
+    }
+    st.mean_batch_size = (st.batches == 0)? 0 : double(st.requests)/st.batches;
+    st.p50_latency_us = percentile(window, 0.50);
+    st.p99_latency_us = percentile(window, 0.99);
+    return st;
+}
@@ -13,15 +13,19 @@
 #include "ann/Layer.h"
 
 Layer::Layer() {
-    /*TODO: Your code is here*/
+    is_training = true;
 }
 
 Layer::Layer(const Layer& orig) {
-    /*TODO: Your code is here*/ 
+    is_training = orig.is_training;
 }
 
 Layer::~Layer() {
 }
 
-unsigned long long Layer::layer_idx =0;
+void Layer::infer(const xt::xarray<double>& /*X*/, xt::xarray<double>& /*Y*/) {
+    throw std::logic_error(name + " does not support reentrant inference");
+}
+
+std::atomic<unsigned long long> Layer::layer_idx(0);
 
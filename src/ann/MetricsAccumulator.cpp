@@ -0,0 +1,59 @@
+/*
+ * File:   MetricsAccumulator.cpp
+ */
+
+#include "ann/MetricsAccumulator.h"
+
+MetricsAccumulator::MetricsAccumulator(int num_classes) {
+    if(num_classes <= 0)
+        throw std::invalid_argument("MetricsAccumulator: num_classes must be positive");
+    m_nClasses = num_classes;
+    m_nTotal = 0;
+    m_bSparse = (num_classes > SPARSE_CONFUSION_THRESHOLD);
+    if(m_bSparse) m_sparse = SparseConfusion(num_classes);
+    else m_counts.assign((size_t)num_classes*num_classes, 0);
+}
+
+void MetricsAccumulator::update(const ulong_array& y_true, const ulong_array& y_pred){
+    if(y_true.size() != y_pred.size())
+        throw std::invalid_argument("MetricsAccumulator: y_true and y_pred differ in size");
+    const ulong* pt = y_true.data();
+    const ulong* pp = y_pred.data();
+    for(size_t idx=0; idx < y_true.size(); idx++) check(pt[idx], pp[idx]);
+    for(size_t idx=0; idx < y_true.size(); idx++) count(pt[idx], pp[idx]);
+    m_nTotal += y_true.size();
+}
+
+void MetricsAccumulator::merge(const MetricsAccumulator& other){
+    if(other.m_nClasses != m_nClasses)
+        throw std::invalid_argument("MetricsAccumulator: cannot merge "
+                + to_string(other.m_nClasses) + " classes into " + to_string(m_nClasses));
+    if(m_bSparse) m_sparse.merge(other.m_sparse);
+    else for(size_t idx=0; idx < m_counts.size(); idx++) m_counts[idx] += other.m_counts[idx];
+    m_nTotal += other.m_nTotal;
+}
+
+void MetricsAccumulator::reset(){
+    if(m_bSparse) m_sparse = SparseConfusion(m_nClasses);
+    else std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_nTotal = 0;
+}
+
+SparseConfusion MetricsAccumulator::sparse_confusion(){
+    if(m_bSparse) return m_sparse;
+    SparseConfusion result(m_nClasses);
+    for(size_t cell=0; cell < m_counts.size(); cell++)
+        if(m_counts[cell] != 0) result.add(cell/m_nClasses, cell%m_nClasses, m_counts[cell]);
+    return result;
+}
+
+ulong_array MetricsAccumulator::confusion(){
+    if(m_bSparse) return m_sparse.to_dense();
+    ulong_array result = xt::adapt(m_counts, std::vector<size_t>{(size_t)m_nClasses, (size_t)m_nClasses});
+    return result;
+}
+
+double_array MetricsAccumulator::metrics(){
+    if(m_bSparse) return calc_metrics(m_sparse);
+    return calc_metrics(confusion());
+}
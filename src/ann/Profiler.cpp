@@ -0,0 +1,107 @@
+/*
+ * File:   Profiler.cpp
+ */
+
+#include "ann/Profiler.h"
+#include <iomanip>
+
+ModelProfiler::ModelProfiler() {
+}
+
+void ModelProfiler::record(int position, string name, const xt::xarray<double>& X,
+                           const xt::xarray<double>& Y, double seconds,
+                           unsigned long long bytes, double flops){
+    string in_shape = shape2str(X.shape());
+    string out_shape = shape2str(Y.shape());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while((int)m_layers.size() <= position){
+        LayerProfile empty = {"", 0, 0, 0, 0, "", "", 0, 0};
+        m_layers.push_back(empty);
+    }
+    LayerProfile& prof = m_layers[position];
+    if(prof.calls == 0 || seconds < prof.min_seconds) prof.min_seconds = seconds;
+    if(seconds > prof.max_seconds) prof.max_seconds = seconds;
+    prof.name = name;
+    prof.calls += 1;
+    prof.total_seconds += seconds;
+    prof.input_shape = in_shape;
+    prof.output_shape = out_shape;
+    prof.bytes_allocated += bytes;
+    prof.flops += flops;
+}
+
+void ModelProfiler::reset(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_layers.clear();
+}
+
+vector<LayerProfile> ModelProfiler::snapshot(){
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_layers;
+}
+
+string ModelProfiler::toTable(){
+    vector<LayerProfile> layers = snapshot();
+    stringstream ss;
+    ss << left << setw(14) << "layer" << right
+       << setw(9) << "calls" << setw(12) << "total(ms)" << setw(11) << "mean(ms)"
+       << setw(11) << "min(ms)" << setw(11) << "max(ms)" << setw(9) << "share"
+       << setw(14) << "alloc(MB)" << setw(10) << "GFLOP/s"
+       << "  " << left << setw(14) << "input" << " -> output" << endl;
+    
+    double total = 0;
+    for(size_t idx=0; idx < layers.size(); idx++) total += layers[idx].total_seconds;
+    ss << fixed;
+    for(size_t idx=0; idx < layers.size(); idx++){
+        LayerProfile& prof = layers[idx];
+        ss << left << setw(14) << prof.name << right
+           << setw(9) << prof.calls
+           << setw(12) << setprecision(3) << 1e3*prof.total_seconds
+           << setw(11) << setprecision(4) << prof.mean_ms()
+           << setw(11) << 1e3*prof.min_seconds
+           << setw(11) << 1e3*prof.max_seconds
+           << setw(8) << setprecision(1) << (total > 0? 100*prof.total_seconds/total : 0) << "%"
+           << setw(14) << setprecision(3) << prof.bytes_allocated/1048576.0;
+        if(prof.flops > 0) ss << setw(10) << setprecision(2) << prof.gflops();
+        else ss << setw(10) << "-";
+        ss << "  " << left << setw(14) << prof.input_shape << " -> " << prof.output_shape << endl;
+    }
+    ss << left << setw(14) << "total" << right << setw(9) << ""
+       << setw(12) << setprecision(3) << 1e3*total << endl;
+    return ss.str();
+}
+
+static string json_escape(const string& str){
+    stringstream ss;
+    for(char c: str){
+        if(c == '"' || c == '\\') ss << '\\' << c;
+        else if((unsigned char)c < 0x20) ss << "\\u" << hex << setw(4) << setfill('0') << (int)c;
+        else ss << c;
+    }
+    return ss.str();
+}
+
+string ModelProfiler::toJSON(){
+    vector<LayerProfile> layers = snapshot();
+    stringstream ss;
+    ss << setprecision(9);
+    ss << "{\"layers\": [";
+    for(size_t idx=0; idx < layers.size(); idx++){
+        LayerProfile& prof = layers[idx];
+        ss << (idx == 0? "" : ", ") << "{"
+           << "\"name\": \"" << json_escape(prof.name) << "\", "
+           << "\"calls\": " << prof.calls << ", "
+           << "\"total_ms\": " << 1e3*prof.total_seconds << ", "
+           << "\"mean_ms\": " << prof.mean_ms() << ", "
+           << "\"min_ms\": " << 1e3*prof.min_seconds << ", "
+           << "\"max_ms\": " << 1e3*prof.max_seconds << ", "
+           << "\"input_shape\": \"" << json_escape(prof.input_shape) << "\", "
+           << "\"output_shape\": \"" << json_escape(prof.output_shape) << "\", "
+           << "\"bytes_allocated\": " << prof.bytes_allocated << ", "
+           << "\"flops\": " << prof.flops << ", "
+           << "\"gflops_per_s\": " << prof.gflops()
+           << "}";
+    }
+    ss << "]}";
+    return ss.str();
+}
@@ -24,5 +24,14 @@ ReLU::~ReLU() {
 }
 
 xt::xarray<double> ReLU::forward(xt::xarray<double> X) {
-    /*TODO: Your code is here*/
+    if(!is_training) return xt::maximum(X, 0.0);
+    mask = X >= 0;
+    return X * mask;
+}
+
+void ReLU::infer(const xt::xarray<double>& X, xt::xarray<double>& Y) {
+    if(!(Y.shape() == X.shape())) Y.resize(X.shape());
+    const double* px = X.data();
+    double* py = Y.data();
+    for(size_t idx=0; idx < X.size(); idx++) py[idx] = (px[idx] > 0)? px[idx] : 0.0;
 }
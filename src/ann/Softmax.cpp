@@ -17,13 +17,19 @@ Softmax::Softmax(int axis): axis(axis) {
     name = "Softmax_" + to_string(++layer_idx);
 }
 
-Softmax::Softmax(const Softmax& orig) {
-    /*TODO: Your code is here*/
+Softmax::Softmax(const Softmax& orig): axis(orig.axis) {
+    name = "Softmax_" + to_string(++layer_idx);
 }
 
 Softmax::~Softmax() {
 }
 
 xt::xarray<double> Softmax::forward(xt::xarray<double> X) {
-    /*TODO: Your code is here*/
+    if(!is_training) return softmax(X, axis);
+    cached_Y = softmax(X, axis);
+    return cached_Y;
+}
+
+void Softmax::infer(const xt::xarray<double>& X, xt::xarray<double>& Y) {
+    softmax_into(X, Y, axis);
 }
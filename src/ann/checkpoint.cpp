@@ -0,0 +1,41 @@
+/*
+ * File:   checkpoint.cpp
+ */
+
+#include "ann/checkpoint.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(string filename): m_sFilename(filename), m_pData(nullptr), m_nSize(0) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::runtime_error("Cannot open " + filename + ": " + strerror(errno));
+
+    struct stat st;
+    if(::fstat(fd, &st) != 0){
+        int err = errno;
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + filename + ": " + strerror(err));
+    }
+    m_nSize = static_cast<size_t>(st.st_size);
+    if(m_nSize == 0){
+        ::close(fd);
+        throw std::runtime_error("Empty file: " + filename);
+    }
+
+    void* ptr = ::mmap(nullptr, m_nSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    ::close(fd); //the mapping keeps its own reference to the file
+    if(ptr == MAP_FAILED)
+        throw std::runtime_error("Cannot mmap " + filename + ": " + strerror(err));
+    m_pData = static_cast<char*>(ptr);
+}
+
+MappedFile::~MappedFile() {
+    if(m_pData != nullptr) ::munmap(m_pData, m_nSize);
+}
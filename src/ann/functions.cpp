@@ -1,11 +1,130 @@
 #include "ann/funtions.h"
+#include <algorithm>
 #include <cinttypes>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <limits>
 
+////////////////////////////////////////////////////////////////////////
+// softmax kernel
+////////////////////////////////////////////////////////////////////////
 
+/* exp_approx(x): exp(x) for the softmax kernel
+ *   >> range reduction x = k*ln2 + r, |r| <= ln2/2, then a degree-11
+ *      Taylor polynomial for exp(r) and 2^k built directly in the exponent;
+ *   >> max relative error < 1e-14 for x in [-708, 0]; inputs below -708,
+ *      including the -inf of a masked logit, give exactly 0 (the true value
+ *      is < 3.3e-308, i.e. nothing next to the row max);
+ *   >> branch-free and without library calls, so loops over it vectorize.
+ */
+static inline double exp_approx(double x){
+    const double LOG2E  = 1.4426950408889634;
+    const double LN2_HI = 6.93147180369123816490e-01;
+    const double LN2_LO = 1.90821492927058770002e-10;
+    const double ROUND  = 6755399441055744.0; //1.5 * 2^52: adding it rounds to integer
+    
+    bool underflow = x < -708.0;
+    x = underflow? -708.0 : x;
+    double t = x*LOG2E + ROUND;
+    double k = t - ROUND;
+    double r = (x - k*LN2_HI) - k*LN2_LO;
+    
+    double p = 1.0/39916800.0;
+    p = p*r + 1.0/3628800.0;
+    p = p*r + 1.0/362880.0;
+    p = p*r + 1.0/40320.0;
+    p = p*r + 1.0/5040.0;
+    p = p*r + 1.0/720.0;
+    p = p*r + 1.0/120.0;
+    p = p*r + 1.0/24.0;
+    p = p*r + 1.0/6.0;
+    p = p*r + 0.5;
+    p = p*r + 1.0;
+    p = p*r + 1.0;
+    
+    //the low mantissa bits of t hold k; move k + bias into the exponent field
+    int64_t tbits, rbits;
+    memcpy(&tbits, &t, sizeof(t));
+    memcpy(&rbits, &ROUND, sizeof(ROUND));
+    int64_t sbits = (tbits - rbits + 1023) << 52;
+    double scale;
+    memcpy(&scale, &sbits, sizeof(scale));
+    return underflow? 0.0 : p*scale;
+}
+
+/* softmax_rows: softmax over each contiguous row of a (rows x cols) buffer
+ *   >> pass 1 reads the row for its max; pass 2 reads it again, writes
+ *      exp(x - max) and accumulates the sum; the final scale touches only
+ *      the output row, which is still in cache.
+ *   >> "in" and "out" may alias.
+ */
+static void softmax_rows(const double* in, double* out, size_t rows, size_t cols){
+    const size_t LANES = 4;
+    size_t cols_main = cols - cols % LANES;
+    for(size_t row=0; row < rows; row++){
+        const double* x = in + row*cols;
+        double* y = out + row*cols;
+        
+        double m0 = x[0], m1 = x[0], m2 = x[0], m3 = x[0];
+        for(size_t c=0; c < cols_main; c += LANES){
+            m0 = (x[c  ] > m0)? x[c  ] : m0;
+            m1 = (x[c+1] > m1)? x[c+1] : m1;
+            m2 = (x[c+2] > m2)? x[c+2] : m2;
+            m3 = (x[c+3] > m3)? x[c+3] : m3;
+        }
+        for(size_t c=cols_main; c < cols; c++) m0 = (x[c] > m0)? x[c] : m0;
+        double xmax = std::max(std::max(m0, m1), std::max(m2, m3));
+        
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for(size_t c=0; c < cols_main; c += LANES){
+            y[c  ] = exp_approx(x[c  ] - xmax); s0 += y[c  ];
+            y[c+1] = exp_approx(x[c+1] - xmax); s1 += y[c+1];
+            y[c+2] = exp_approx(x[c+2] - xmax); s2 += y[c+2];
+            y[c+3] = exp_approx(x[c+3] - xmax); s3 += y[c+3];
+        }
+        for(size_t c=cols_main; c < cols; c++){
+            y[c] = exp_approx(x[c] - xmax); s0 += y[c];
+        }
+        
+        double inv_sum = 1.0/((s0 + s1) + (s2 + s3));
+        for(size_t c=0; c < cols; c++) y[c] *= inv_sum;
+    }
+}
 
 xt::xarray<double> softmax(xt::xarray<double> X, int axis){
-    /*TODO: Your code is here*/
+    if(X.dimension() == 0)
+        throw std::invalid_argument("softmax: input must have at least one dimension");
+    int ndim = X.dimension();
+    axis = positive_index(axis, ndim);
+    if(axis < 0 || axis >= ndim)
+        throw std::out_of_range("softmax: axis is out of range!");
+    if(X.size() == 0) return X;
+    
+    if(axis == ndim - 1){
+        //fast path: rows are contiguous, work in place on our own copy of X
+        size_t cols = X.shape()[axis];
+        softmax_rows(X.data(), X.data(), X.size()/cols, cols);
+        return X;
+    }
+    //other axes: make the axis innermost and contiguous, then swap back
+    xt::xarray<double> Xt = xt::swapaxes(X, axis, ndim - 1);
+    size_t cols = Xt.shape()[ndim - 1];
+    softmax_rows(Xt.data(), Xt.data(), Xt.size()/cols, cols);
+    xt::xarray<double> Y = xt::swapaxes(Xt, axis, ndim - 1);
+    return Y;
+}
+
+void softmax_into(const xt::xarray<double>& X, xt::xarray<double>& Y, int axis){
+    int ndim = X.dimension();
+    if(ndim == 0 || positive_index(axis, ndim) != ndim - 1 || X.size() == 0){
+        xt::xarray<double> result = softmax(X, axis);
+        //copy rather than move-assign, so Y keeps its buffer as promised
+        if(!(Y.shape() == X.shape())) Y.resize(X.shape());
+        std::copy(result.data(), result.data() + result.size(), Y.data());
+        return;
+    }
+    if(!(Y.shape() == X.shape())) Y.resize(X.shape());
+    size_t cols = X.shape()[ndim - 1];
+    softmax_rows(X.data(), Y.data(), X.size()/cols, cols);
 }
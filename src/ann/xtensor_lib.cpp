@@ -4,6 +4,8 @@
  */
 
 #include "ann/xtensor_lib.h"
+#include <thread>
+#include <vector>
 
 
 string shape2str(xt::svector<unsigned long> vec){
@@ -23,26 +25,322 @@ int positive_index(int idx, int size){
     return idx;
 }
 
-//should use einsum if it exists
+static void check_stack(const xt::xarray<double>& X, size_t ndim, string func, string arg){
+    if(X.dimension() != ndim)
+        throw std::invalid_argument(func + ": " + arg + " must have " + to_string(ndim)
+                + " dimensions, got " + shape2str(X.shape()));
+}
+
+//the stacked helpers below work on raw row-major buffers (arguments are contiguous copies)
 xt::xarray<double> outer_stack(xt::xarray<double> X, xt::xarray<double>  Y){
-    /*TODO: Your code is here*/
+    check_stack(X, 2, "outer_stack", "X");
+    check_stack(Y, 2, "outer_stack", "Y");
+    size_t nbatch = X.shape()[0], na = X.shape()[1], nb = Y.shape()[1];
+    if(Y.shape()[0] != nbatch)
+        throw std::invalid_argument("outer_stack: batch sizes differ: " + shape2str(X.shape())
+                + " vs " + shape2str(Y.shape()));
+    
+    xt::xarray<double> result = xt::empty<double>({nbatch, na, nb});
+    const double* px = X.data();
+    const double* py = Y.data();
+    double* pr = result.data();
+    for(size_t n=0; n < nbatch; n++){
+        const double* x = px + n*na;
+        const double* y = py + n*nb;
+        for(size_t a=0; a < na; a++){
+            double xa = x[a];
+            double* row = pr + (n*na + a)*nb;
+            for(size_t b=0; b < nb; b++) row[b] = xa*y[b];
+        }
+    }
+    return result;
 }
 xt::xarray<double> diag_stack(xt::xarray<double> X){
-    /*TODO: Your code is here*/
+    check_stack(X, 2, "diag_stack", "X");
+    size_t nbatch = X.shape()[0], nd = X.shape()[1];
+    xt::xarray<double> result = xt::zeros<double>({nbatch, nd, nd});
+    const double* px = X.data();
+    double* pr = result.data();
+    for(size_t n=0; n < nbatch; n++)
+        for(size_t d=0; d < nd; d++) pr[(n*nd + d)*nd + d] = px[n*nd + d];
+    return result;
 }
 xt::xarray<double> matmul_on_stack(xt::xarray<double> X, xt::xarray<double>  Y){
-    /*TODO: Your code is here*/
+    check_stack(X, 3, "matmul_on_stack", "X");
+    if(Y.dimension() != 2 && Y.dimension() != 3)
+        throw std::invalid_argument("matmul_on_stack: Y must have 2 or 3 dimensions, got "
+                + shape2str(Y.shape()));
+    bool is_vector = (Y.dimension() == 2);
+    size_t nbatch = X.shape()[0], na = X.shape()[1], nb = X.shape()[2];
+    size_t nc = is_vector? 1 : Y.shape()[2];
+    if(Y.shape()[0] != nbatch || Y.shape()[1] != nb)
+        throw std::invalid_argument("matmul_on_stack: cannot multiply " + shape2str(X.shape())
+                + " by " + shape2str(Y.shape()));
+    
+    xt::xarray<double> result = is_vector? xt::xarray<double>(xt::empty<double>({nbatch, na}))
+                                         : xt::xarray<double>(xt::empty<double>({nbatch, na, nc}));
+    if(result.size() == 0) return result;
+    if(nb == 0){
+        result.fill(0);
+        return result;
+    }
+    const double* px = X.data();
+    const double* py = Y.data();
+    double* pr = result.data();
+    //strided batch: entry n starts at n*stride in each buffer
+    size_t stride_x = na*nb, stride_y = nb*nc, stride_r = na*nc;
+    for(size_t n=0; n < nbatch; n++){
+        cxxblas::gemm<xt::blas_index_t>(cxxblas::StorageOrder::RowMajor,
+                cxxblas::Transpose::NoTrans, cxxblas::Transpose::NoTrans,
+                na, nc, nb,
+                1.0, px + n*stride_x, nb,
+                py + n*stride_y, nc,
+                0.0, pr + n*stride_r, nc);
+    }
+    return result;
+}
+
+xt::xarray<double> softmax_jacobian_dot(xt::xarray<double> Y, xt::xarray<double> DY){
+    check_stack(Y, 2, "softmax_jacobian_dot", "Y");
+    if(!(DY.shape() == Y.shape()))
+        throw std::invalid_argument("softmax_jacobian_dot: DY " + shape2str(DY.shape())
+                + " does not match Y " + shape2str(Y.shape()));
+    size_t nbatch = Y.shape()[0], nd = Y.shape()[1];
+    const double* py = Y.data();
+    double* pg = DY.data(); //our own copy: overwritten with the result
+    for(size_t n=0; n < nbatch; n++){
+        const double* y = py + n*nd;
+        double* g = pg + n*nd;
+        double dot = 0;
+        for(size_t d=0; d < nd; d++) dot += y[d]*g[d];
+        for(size_t d=0; d < nd; d++) g[d] = y[d]*(g[d] - dot);
+    }
+    return DY;
+}
+
+
+////////////////////////////////////////////////////////////////////////
+// confusion matrix & metrics
+////////////////////////////////////////////////////////////////////////
+#define CONFUSION_MIN_SAMPLES_PER_THREAD 65536
+#define CONFUSION_PRIVATE_BUDGET (64ul << 20) //bytes of private histograms, all threads
+
+static ulong count_classes(const ulong_array& y_true, const ulong_array& y_pred){
+    ulong nclasses = 0;
+    for(ulong label: y_true) nclasses = std::max(nclasses, label + 1);
+    for(ulong label: y_pred) nclasses = std::max(nclasses, label + 1);
+    return nclasses;
+}
+
+/* confusion_threads: how many workers to use for "nsamples" samples
+ */
+static size_t confusion_threads(size_t nsamples){
+    size_t nthreads = std::max(1u, std::thread::hardware_concurrency());
+    nthreads = std::min(nthreads, nsamples/CONFUSION_MIN_SAMPLES_PER_THREAD);
+    return std::max<size_t>(nthreads, 1);
+}
+
+/* run_chunks: call fn(worker, begin, end) on "nthreads" threads over [0, n)
+ */
+template <class Fn>
+static void run_chunks(size_t nthreads, size_t n, Fn fn){
+    if(nthreads <= 1){
+        fn(0, 0, n);
+        return;
+    }
+    vector<std::thread> workers;
+    size_t chunk = (n + nthreads - 1)/nthreads;
+    for(size_t w=0; w < nthreads; w++){
+        size_t begin = std::min(n, w*chunk), end = std::min(n, begin + chunk);
+        workers.push_back(std::thread(fn, w, begin, end));
+    }
+    for(std::thread& worker: workers) worker.join();
+}
+
+ulong_array confusion_matrix(ulong_array y_true, ulong_array y_pred, ulong_array* class_counts,
+                             int nthreads){
+    if(y_true.size() != y_pred.size())
+        throw std::invalid_argument("confusion_matrix: y_true and y_pred differ in size");
+    ulong nclasses = count_classes(y_true, y_pred);
+    size_t ncells = (size_t)nclasses*nclasses;
+    size_t nsamples = y_true.size();
+    const ulong* pt = y_true.data();
+    const ulong* pp = y_pred.data();
+    
+    ulong_array confusion = xt::zeros<ulong>({nclasses, nclasses});
+    ulong_array support = xt::zeros<ulong>({nclasses});
+    ulong* counts = confusion.data();
+    ulong* rows = support.data();
+    size_t workers = (nthreads > 0)? nthreads : confusion_threads(nsamples);
+    if(workers == 1){
+        for(size_t idx=0; idx < nsamples; idx++){
+            counts[pt[idx]*nclasses + pp[idx]] += 1;
+            rows[pt[idx]] += 1;
+        }
+    }
+    else if((workers - 1)*ncells*sizeof(ulong) <= CONFUSION_PRIVATE_BUDGET){
+        //privatized histograms: worker 0 counts straight into the result
+        vector<vector<ulong>> privates(workers - 1, vector<ulong>(ncells, 0));
+        vector<vector<ulong>> private_rows(workers - 1, vector<ulong>(nclasses, 0));
+        run_chunks(workers, nsamples, [&](size_t worker, size_t begin, size_t end){
+            ulong* local = (worker == 0)? counts : privates[worker - 1].data();
+            ulong* local_rows = (worker == 0)? rows : private_rows[worker - 1].data();
+            for(size_t idx=begin; idx < end; idx++){
+                local[pt[idx]*nclasses + pp[idx]] += 1;
+                local_rows[pt[idx]] += 1;
+            }
+        });
+        for(size_t w=0; w < workers - 1; w++){
+            for(size_t cell=0; cell < ncells; cell++) counts[cell] += privates[w][cell];
+            for(size_t k=0; k < nclasses; k++) rows[k] += private_rows[w][k];
+        }
+    }
+    else{
+        //too many classes for private copies: worker w owns rows [begin, end)
+        //of the result and reads every sample, counting only its own rows
+        run_chunks(workers, nclasses, [&](size_t, size_t begin, size_t end){
+            for(size_t idx=0; idx < nsamples; idx++){
+                ulong label = pt[idx];
+                if(label < begin || label >= end) continue;
+                counts[label*nclasses + pp[idx]] += 1;
+                rows[label] += 1;
+            }
+        });
+    }
+    if(class_counts != nullptr) *class_counts = std::move(support);
+    return confusion;
+}
+
+SparseConfusion confusion_matrix_sparse(ulong_array y_true, ulong_array y_pred){
+    if(y_true.size() != y_pred.size())
+        throw std::invalid_argument("confusion_matrix: y_true and y_pred differ in size");
+    ulong nclasses = count_classes(y_true, y_pred);
+    size_t nsamples = y_true.size();
+    const ulong* pt = y_true.data();
+    const ulong* pp = y_pred.data();
+    
+    size_t nthreads = confusion_threads(nsamples);
+    vector<SparseConfusion> partial(nthreads, SparseConfusion(nclasses));
+    run_chunks(nthreads, nsamples, [&](size_t worker, size_t begin, size_t end){
+        SparseConfusion& local = partial[worker];
+        for(size_t idx=begin; idx < end; idx++) local.add(pt[idx], pp[idx]);
+    });
+    for(size_t w=1; w < nthreads; w++) partial[0].merge(partial[w]);
+    return partial[0];
+}
+
+void SparseConfusion::merge(const SparseConfusion& other){
+    if(other.m_nClasses > m_nClasses){
+        //re-key: the flat index depends on the number of classes
+        unordered_map<unsigned long long, ulong> rekeyed;
+        rekeyed.reserve(m_cells.size());
+        for(auto& cell: m_cells)
+            rekeyed[(cell.first/m_nClasses)*other.m_nClasses + cell.first%m_nClasses] = cell.second;
+        m_cells.swap(rekeyed);
+        m_nClasses = other.m_nClasses;
+    }
+    for(auto& cell: other.m_cells)
+        add(cell.first/other.m_nClasses, cell.first%other.m_nClasses, cell.second);
 }
 
+ulong SparseConfusion::get(ulong label, ulong pred) const {
+    auto it = m_cells.find((unsigned long long)label*m_nClasses + pred);
+    return (it == m_cells.end())? 0 : it->second;
+}
 
-ulong_array confusion_matrix(ulong_array y_true, ulong_array y_pred){
-    /*TODO: Your code is here*/
+ulong_array SparseConfusion::to_dense() const {
+    ulong_array dense = xt::zeros<ulong>({m_nClasses, m_nClasses});
+    ulong* counts = dense.data();
+    for(auto& cell: m_cells) counts[cell.first] = cell.second;
+    return dense;
 }
+
 xt::xarray<ulong> class_count(xt::xarray<ulong> confusion){
-    xt::xarray<ulong> count = xt::sum(confusion, -1);
+    if(confusion.dimension() != 2 || confusion.shape()[0] != confusion.shape()[1])
+        throw std::invalid_argument("class_count: confusion must be square, got "
+                + shape2str(confusion.shape()));
+    size_t nclasses = confusion.shape()[0];
+    const ulong* counts = confusion.data();
+    xt::xarray<ulong> count = xt::zeros<ulong>({nclasses});
+    for(size_t t=0; t < nclasses; t++)
+        for(size_t p=0; p < nclasses; p++) count[t] += counts[t*nclasses + p];
+    return count;
+}
+
+xt::xarray<ulong> class_count(const SparseConfusion& confusion){
+    ulong nclasses = confusion.nclasses();
+    xt::xarray<ulong> count = xt::zeros<ulong>({nclasses});
+    for(auto& cell: confusion.cells()) count[cell.first/nclasses] += cell.second;
     return count;
 }
 
+/* metrics_from_counts: every class_metrics entry needs only, per class, the
+ *      true positives, the support (row sum) and the predicted count (column sum)
+ */
+static double_array metrics_from_counts(const vector<double>& tp, const vector<double>& support,
+                                        const vector<double>& predicted){
+    size_t nclasses = tp.size();
+    double total = 0;
+    for(size_t k=0; k < nclasses; k++) total += support[k];
+    
+    double_array result = xt::zeros<double>({(size_t)NUM_CLASS_METRICS});
+    if(total == 0 || nclasses == 0) return result;
+    double* metrics = result.data();
+    double correct = 0;
+    for(size_t k=0; k < nclasses; k++){
+        double precision = (predicted[k] > 0)? tp[k]/predicted[k] : 0;
+        double recall = (support[k] > 0)? tp[k]/support[k] : 0;
+        double f1 = (precision + recall > 0)? 2*precision*recall/(precision + recall) : 0;
+        double weight = support[k]/total;
+        correct += tp[k];
+        metrics[PRECISION_MACRO] += precision;
+        metrics[RECALL_MACRO] += recall;
+        metrics[F1_MEASURE_MACRO] += f1;
+        metrics[PRECISION_WEIGHTED] += weight*precision;
+        metrics[RECALL_WEIGHTED] += weight*recall;
+        metrics[F1_MEASURE_WEIGHTED] += weight*f1;
+    }
+    metrics[ACCURACY] = correct/total;
+    metrics[PRECISION_MACRO] /= nclasses;
+    metrics[RECALL_MACRO] /= nclasses;
+    metrics[F1_MEASURE_MACRO] /= nclasses;
+    return result;
+}
+
 double_array calc_metrics(ulong_array y_true, ulong_array y_pred){
-    /*TODO: Your code is here*/
-}
\ No newline at end of file
+    if(y_true.size() != y_pred.size())
+        throw std::invalid_argument("calc_metrics: y_true and y_pred differ in size");
+    if(count_classes(y_true, y_pred) > SPARSE_CONFUSION_THRESHOLD)
+        return calc_metrics(confusion_matrix_sparse(y_true, y_pred));
+    return calc_metrics(confusion_matrix(y_true, y_pred));
+}
+
+double_array calc_metrics(ulong_array confusion){
+    if(confusion.dimension() != 2 || confusion.shape()[0] != confusion.shape()[1])
+        throw std::invalid_argument("calc_metrics: confusion must be square, got "
+                + shape2str(confusion.shape()));
+    size_t nclasses = confusion.shape()[0];
+    const ulong* counts = confusion.data();
+    vector<double> tp(nclasses, 0), support(nclasses, 0), predicted(nclasses, 0);
+    for(size_t t=0; t < nclasses; t++){
+        for(size_t p=0; p < nclasses; p++){
+            double n = counts[t*nclasses + p];
+            support[t] += n;
+            predicted[p] += n;
+        }
+        tp[t] = counts[t*nclasses + t];
+    }
+    return metrics_from_counts(tp, support, predicted);
+}
+
+double_array calc_metrics(const SparseConfusion& confusion){
+    size_t nclasses = confusion.nclasses();
+    vector<double> tp(nclasses, 0), support(nclasses, 0), predicted(nclasses, 0);
+    for(auto& cell: confusion.cells()){
+        size_t t = cell.first/nclasses, p = cell.first%nclasses;
+        support[t] += cell.second;
+        predicted[p] += cell.second;
+        if(t == p) tp[t] += cell.second;
+    }
+    return metrics_from_counts(tp, support, predicted);
+}
@@ -0,0 +1,237 @@
+/*
+ * File:   AllocTracker.cpp
+ */
+
+#include "util/AllocTracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+namespace {
+//Counters must be usable before any dynamic initialization runs (operator
+//new is called during static construction), so they are plain zero-
+//initialized atomics with no constructor work.
+struct AllocCounters {
+    std::atomic<unsigned long long> allocations;
+    std::atomic<unsigned long long> deallocations;
+    std::atomic<unsigned long long> bytes_allocated;
+    std::atomic<long long> live_bytes;
+    std::atomic<long long> peak_bytes;
+};
+
+AllocCounters g_counters[ALLOC_NUM_SUBSYSTEMS + 1];
+thread_local int t_current = ALLOC_OTHER;
+
+int clamp_subsystem(int subsystem){
+    return (subsystem < 0 || subsystem > ALLOC_NUM_SUBSYSTEMS)? ALLOC_OTHER : subsystem;
+}
+
+void raise_peak(std::atomic<long long>& peak, long long value){
+    long long seen = peak.load(std::memory_order_relaxed);
+    while(value > seen &&
+          !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed));
+}
+
+void add_alloc(AllocCounters& cnt, size_t bytes){
+    cnt.allocations.fetch_add(1, std::memory_order_relaxed);
+    cnt.bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+    long long live = cnt.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    raise_peak(cnt.peak_bytes, live);
+}
+
+void add_free(AllocCounters& cnt, size_t bytes){
+    cnt.deallocations.fetch_add(1, std::memory_order_relaxed);
+    cnt.live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+AllocStats load_stats(AllocCounters& cnt){
+    AllocStats st;
+    st.allocations = cnt.allocations.load(std::memory_order_relaxed);
+    st.deallocations = cnt.deallocations.load(std::memory_order_relaxed);
+    st.bytes_allocated = cnt.bytes_allocated.load(std::memory_order_relaxed);
+    st.live_bytes = cnt.live_bytes.load(std::memory_order_relaxed);
+    st.peak_bytes = cnt.peak_bytes.load(std::memory_order_relaxed);
+    return st;
+}
+
+string stats_table(const AllocStats* rows){
+    stringstream ss;
+    ss << left << setw(14) << "subsystem" << right
+       << setw(14) << "allocs" << setw(14) << "frees"
+       << setw(14) << "alloc(MB)" << setw(12) << "live(MB)" << setw(12) << "peak(MB)" << endl;
+    ss << fixed << setprecision(3);
+    for(int sub=0; sub <= ALLOC_NUM_SUBSYSTEMS; sub++){
+        const AllocStats& st = rows[sub];
+        if(sub < ALLOC_NUM_SUBSYSTEMS && st.allocations == 0 && st.deallocations == 0) continue;
+        ss << left << setw(14) << AllocTracker::name(sub) << right
+           << setw(14) << st.allocations << setw(14) << st.deallocations
+           << setw(14) << st.bytes_allocated/1048576.0
+           << setw(12) << st.live_bytes/1048576.0
+           << setw(12) << st.peak_bytes/1048576.0 << endl;
+    }
+    return ss.str();
+}
+}
+
+bool AllocTracker::enabled(){
+#ifdef ALLOC_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AllocTracker::record_alloc(int subsystem, size_t bytes){
+    add_alloc(g_counters[clamp_subsystem(subsystem)], bytes);
+    add_alloc(g_counters[ALLOC_NUM_SUBSYSTEMS], bytes);
+}
+
+void AllocTracker::record_free(int subsystem, size_t bytes){
+    add_free(g_counters[clamp_subsystem(subsystem)], bytes);
+    add_free(g_counters[ALLOC_NUM_SUBSYSTEMS], bytes);
+}
+
+AllocStats AllocTracker::stats(int subsystem){
+    return load_stats(g_counters[clamp_subsystem(subsystem)]);
+}
+
+void AllocTracker::reset(){
+    for(int sub=0; sub <= ALLOC_NUM_SUBSYSTEMS; sub++){
+        AllocCounters& cnt = g_counters[sub];
+        cnt.allocations.store(0, std::memory_order_relaxed);
+        cnt.deallocations.store(0, std::memory_order_relaxed);
+        cnt.bytes_allocated.store(0, std::memory_order_relaxed);
+        cnt.peak_bytes.store(cnt.live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+int AllocTracker::current(){
+    return t_current;
+}
+
+int AllocTracker::set_current(int subsystem){
+    int previous = t_current;
+    t_current = clamp_subsystem(subsystem);
+    return previous;
+}
+
+string AllocTracker::name(int subsystem){
+    switch(subsystem){
+        case ALLOC_OTHER:           return "other";
+        case ALLOC_XARRAYLIST:      return "XArrayList";
+        case ALLOC_DLINKEDLIST:     return "DLinkedList";
+        case ALLOC_XDEQUE:          return "XDeque";
+        case ALLOC_ANN:             return "ann";
+        case ALLOC_DATA:            return "data";
+        case ALLOC_NUM_SUBSYSTEMS:  return "total";
+        default:                    return "?";
+    }
+}
+
+string AllocTracker::toTable(){
+    AllocStats rows[ALLOC_NUM_SUBSYSTEMS + 1];
+    for(int sub=0; sub <= ALLOC_NUM_SUBSYSTEMS; sub++) rows[sub] = stats(sub);
+    return stats_table(rows);
+}
+
+long long AllocTracker::begin_peak(int subsystem){
+    AllocCounters& cnt = g_counters[subsystem];
+    return cnt.peak_bytes.exchange(cnt.live_bytes.load(std::memory_order_relaxed),
+                                   std::memory_order_relaxed);
+}
+
+void AllocTracker::end_peak(int subsystem, long long outer_peak){
+    raise_peak(g_counters[subsystem].peak_bytes, outer_peak);
+}
+
+AllocRegion::AllocRegion(string name): m_sName(name) {
+    for(int sub=0; sub <= ALLOC_NUM_SUBSYSTEMS; sub++){
+        m_aOuterPeak[sub] = AllocTracker::begin_peak(sub);
+        m_aStart[sub] = AllocTracker::stats(sub);
+    }
+}
+
+AllocRegion::~AllocRegion(){
+    for(int sub=0; sub <= ALLOC_NUM_SUBSYSTEMS; sub++)
+        AllocTracker::end_peak(sub, m_aOuterPeak[sub]);
+}
+
+AllocStats AllocRegion::delta(int subsystem){
+    int sub = clamp_subsystem(subsystem);
+    AllocStats now = AllocTracker::stats(sub);
+    const AllocStats& start = m_aStart[sub];
+    AllocStats st;
+    st.allocations = now.allocations - start.allocations;
+    st.deallocations = now.deallocations - start.deallocations;
+    st.bytes_allocated = now.bytes_allocated - start.bytes_allocated;
+    st.live_bytes = now.live_bytes - start.live_bytes;
+    st.peak_bytes = now.peak_bytes - start.live_bytes;
+    return st;
+}
+
+string AllocRegion::toString(){
+    AllocStats rows[ALLOC_NUM_SUBSYSTEMS + 1];
+    for(int sub=0; sub <= ALLOC_NUM_SUBSYSTEMS; sub++) rows[sub] = delta(sub);
+    stringstream ss;
+    ss << "allocations in region";
+    if(!m_sName.empty()) ss << " \"" << m_sName << "\"";
+    if(!AllocTracker::enabled()) ss << " (ALLOC_TRACKING is off)";
+    ss << ":" << endl << stats_table(rows);
+    return ss.str();
+}
+
+#ifdef ALLOC_TRACKING
+//Global operator new/delete: every block carries a small header with its
+//size and the subsystem it was charged to, so the matching delete can
+//credit the same subsystem even when another thread frees it.
+//The aligned (std::align_val_t) forms are left to the runtime.
+namespace {
+struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) AllocHeader {
+    size_t bytes;
+    int subsystem;
+};
+
+void* tracked_new(size_t bytes, bool nothrow){
+    while(true){
+        void* raw = std::malloc(sizeof(AllocHeader) + bytes);
+        if(raw != nullptr){
+            AllocHeader* hdr = static_cast<AllocHeader*>(raw);
+            hdr->bytes = bytes;
+            hdr->subsystem = t_current;
+            AllocTracker::record_alloc(hdr->subsystem, bytes);
+            return hdr + 1;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if(handler == nullptr){
+            if(nothrow) return nullptr;
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void tracked_delete(void* ptr) noexcept {
+    if(ptr == nullptr) return;
+    AllocHeader* hdr = static_cast<AllocHeader*>(ptr) - 1;
+    AllocTracker::record_free(hdr->subsystem, hdr->bytes);
+    std::free(hdr);
+}
+}
+
+void* operator new(size_t bytes){ return tracked_new(bytes, false); }
+void* operator new[](size_t bytes){ return tracked_new(bytes, false); }
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept {
+    try { return tracked_new(bytes, true); } catch(...) { return nullptr; }
+}
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept {
+    try { return tracked_new(bytes, true); } catch(...) { return nullptr; }
+}
+void operator delete(void* ptr) noexcept { tracked_delete(ptr); }
+void operator delete[](void* ptr) noexcept { tracked_delete(ptr); }
+void operator delete(void* ptr, size_t) noexcept { tracked_delete(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { tracked_delete(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { tracked_delete(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { tracked_delete(ptr); }
+#endif
@@ -0,0 +1,58 @@
+/*
+ * File:   harness.h
+ *
+ * Minimal self-contained test harness for the tests executable.
+ * A test is a function that makes CHECK / CHECK_THROWS assertions; a failed
+ * check is reported with its file and line and the test carries on, an
+ * uncaught exception ends the test and counts as a failure. Checks may be
+ * made from any thread the test starts.
+ *
+ *   tests [--filter=substring]
+ *
+ * Test names are "group/what/case"; test/CMakeLists.txt registers one ctest
+ * entry per group (--filter=group/). The exit code is non-zero if anything
+ * failed.
+ */
+
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+#include <functional>
+#include <string>
+using namespace std;
+
+/* record one check; called through the macros below */
+void test_check(bool ok, const char* expr, const char* file, int line);
+
+#define CHECK(expr) test_check((expr) ? true : false, #expr, __FILE__, __LINE__)
+#define CHECK_THROWS(stmt, exception)                                    \
+    do {                                                                 \
+        bool thrown_ = false;                                            \
+        try { stmt; } catch (exception&) { thrown_ = true; }             \
+        test_check(thrown_, #stmt " throws " #exception, __FILE__, __LINE__); \
+    } while (0)
+
+class TestHarness {
+public:
+    TestHarness(int argc, char** argv);
+
+    /* run(name, fn): run one test unless the filter excludes it
+     */
+    void run(string name, std::function<void()> fn);
+    bool enabled(string name);
+
+    int finish();
+
+private:
+    string m_sFilter;
+    int m_nRun;
+    int m_nFailed;
+};
+
+//test groups, one per source file
+void test_lists(TestHarness& harness);
+void test_map(TestHarness& harness);
+void test_concurrent(TestHarness& harness);
+void test_ann(TestHarness& harness);
+void test_util(TestHarness& harness);
+
+#endif /* TEST_HARNESS_H */
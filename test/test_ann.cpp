@@ -0,0 +1,466 @@
+/*
+ * File:   test_ann.cpp
+ *
+ * Checkpoint round-trip, corrupt-file rejection and FCLayer::fromPretrained,
+ * inference from several threads (InferenceEngine, profiling toggled during
+ * predict), batch-wise metrics, softmax against std::exp, and confusion
+ * counts and metrics against a naive count. Model outputs (dense and CSR
+ * input) and the stack kernels are checked against xt::linalg.
+ */
+
+#include "harness.h"
+#include "ann/BaseModel.h"
+#include "ann/FCLayer.h"
+#include "ann/InferenceEngine.h"
+#include "ann/MetricsAccumulator.h"
+#include "ann/ReLU.h"
+#include "ann/Softmax.h"
+#include "ann/checkpoint.h"
+#include "ann/dataloader.h"
+#include "ann/funtions.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+static const char* CHECKPOINT_FILE = "test_checkpoint.ckpt";
+
+static BaseModel* small_model(){
+    Layer* seq[] = {new FCLayer(4, 8), new ReLU(), new FCLayer(8, 3, false), new Softmax()};
+    return new BaseModel(seq, 4);
+}
+
+static vector<char> read_file(const char* filename){
+    ifstream is(filename, ios::binary);
+    return vector<char>(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+}
+
+static void write_file(const char* filename, vector<char>& bytes){
+    ofstream os(filename, ios::binary);
+    os.write(bytes.data(), bytes.size());
+}
+
+static void test_checkpoint_round_trip(){
+    BaseModel* model = small_model();
+    model->eval();
+    xt::xarray<double> X = xt::random::randn<double>({5, 4});
+    xt::xarray<double> expected = model->predict(X);
+    model->save(CHECKPOINT_FILE);
+
+    BaseModel* loaded = BaseModel::load(CHECKPOINT_FILE);
+    loaded->eval();
+    CHECK(loaded->num_layers() == model->num_layers());
+    xt::xarray<double> actual = loaded->predict(X);
+    CHECK(actual.shape() == expected.shape());
+    CHECK(xt::amax(xt::abs(actual - expected))() == 0);
+    delete loaded;
+    delete model;
+    std::remove(CHECKPOINT_FILE);
+}
+
+//records whose sizes or offsets would overflow a naive bounds check
+static void test_checkpoint_corrupt_records(){
+    BaseModel* model = small_model();
+    model->save(CHECKPOINT_FILE);
+    delete model;
+    vector<char> good = read_file(CHECKPOINT_FILE);
+
+    auto load_with = [&](void (*corrupt)(CheckpointLayerRecord&)){
+        vector<char> bytes = good;
+        corrupt(*reinterpret_cast<CheckpointLayerRecord*>(bytes.data() + sizeof(CheckpointHeader)));
+        write_file(CHECKPOINT_FILE, bytes);
+        delete BaseModel::load(CHECKPOINT_FILE);
+    };
+    load_with([](CheckpointLayerRecord&){});
+    CHECK_THROWS(load_with([](CheckpointLayerRecord& rec){
+        rec.in_features = 0x7fffffff;
+        rec.out_features = 0x7fffffff;
+    }), std::runtime_error);
+    CHECK_THROWS(load_with([](CheckpointLayerRecord& rec){ rec.weight_offset = ~uint64_t(63); }),
+                 std::runtime_error);
+    CHECK_THROWS(load_with([](CheckpointLayerRecord& rec){ rec.bias_offset = ~uint64_t(63); }),
+                 std::runtime_error);
+    CHECK_THROWS(BaseModel::load("missing.ckpt"), std::runtime_error);
+    std::remove(CHECKPOINT_FILE);
+}
+
+static void test_fc_from_pretrained(){
+    BaseModel* model = small_model();
+    model->eval();
+    model->save(CHECKPOINT_FILE);
+    xt::xarray<double> X = xt::random::randn<double>({5, 4});
+    FCLayer* layer = FCLayer::fromPretrained(CHECKPOINT_FILE, true);
+    CHECK(layer->get_in_features() == 4 && layer->get_out_features() == 8);
+    CHECK(xt::amax(xt::abs(layer->forward(X) - model->get_layer(0)->forward(X)))() == 0);
+    delete layer;
+    delete model;
+
+    Layer* seq[] = {new ReLU(), new FCLayer(4, 3, false)};
+    model = new BaseModel(seq, 2);
+    model->save(CHECKPOINT_FILE);
+    CHECK_THROWS(FCLayer::fromPretrained(CHECKPOINT_FILE, true), std::runtime_error);
+    layer = FCLayer::fromPretrained(CHECKPOINT_FILE, false);
+    CHECK(xt::amax(xt::abs(layer->forward(X) - model->get_layer(1)->forward(X)))() == 0);
+    delete layer;
+    delete model;
+    CHECK_THROWS(FCLayer::fromPretrained("missing.ckpt", false), std::runtime_error);
+    std::remove(CHECKPOINT_FILE);
+}
+
+static void test_inference_engine(){
+    BaseModel* model = small_model();
+    model->eval();
+    xt::xarray<double> X = xt::random::randn<double>({64, 4});
+    xt::xarray<double> expected = model->predict(X);
+    {
+        InferenceConfig config;
+        config.max_batch_size = 8;
+        config.max_latency_us = 500;
+        InferenceEngine engine(model, config);
+        //the first sample fixes the shape; one of another shape is turned away on its own
+        xt::xarray<double> first = xt::view(X, 0);
+        std::future<xt::xarray<double>> pending = engine.submit(first);
+        CHECK_THROWS(engine.submit(xt::ones<double>({5})), std::invalid_argument);
+        CHECK(xt::amax(xt::abs(pending.get() - xt::view(expected, 0)))() < 1e-12);
+        vector<std::thread> clients;
+        for(int t=0; t < 4; t++) clients.emplace_back([&, t]{
+            for(int i=t; i < 64; i += 4){
+                xt::xarray<double> sample = xt::view(X, i);
+                xt::xarray<double> row = engine.submit(sample).get();
+                CHECK(xt::amax(xt::abs(row - xt::view(expected, i)))() < 1e-12);
+            }
+        });
+        for(std::thread& client: clients) client.join();
+        CHECK_THROWS(engine.submit(xt::ones<double>({5})), std::invalid_argument);
+        CHECK(engine.stats().requests == 65);
+    }
+    delete model;
+}
+
+//switching profiling off while other threads are inside predict must be safe
+static void test_profiling_toggle(){
+    BaseModel* model = small_model();
+    model->eval();
+    xt::xarray<double> X = xt::random::randn<double>({16, 4});
+    vector<std::thread> threads;
+    for(int t=0; t < 2; t++) threads.emplace_back([&]{
+        for(int i=0; i < 200; i++) CHECK(model->predict(X).shape()[0] == 16);
+    });
+    for(int i=0; i < 200; i++) model->enable_profiling(i%2 == 0);
+    for(std::thread& thread: threads) thread.join();
+    model->enable_profiling(true);
+    model->predict(X);
+    CHECK(model->profiler() != nullptr);
+    model->enable_profiling(false);
+    CHECK(model->profiler() == nullptr);
+    delete model;
+}
+
+static void test_metrics_batch_is_atomic(){
+    MetricsAccumulator metrics(3);
+    ulong_array y_true = {0, 1, 2, 5}, y_pred = {0, 1, 1, 0};
+    CHECK_THROWS(metrics.update(y_true, y_pred), std::out_of_range);
+    CHECK(metrics.total() == 0 && xt::sum(metrics.confusion())() == 0);
+
+    ulong_array good_true = {0, 1, 2}, good_pred = {0, 2, 2};
+    metrics.update(good_true, good_pred);
+    xt::xarray<int> labels = {0, 7};
+    double_array logits = {{1, 0, 0}, {0, 1, 0}};
+    CHECK_THROWS(metrics.update_logits(labels, logits), std::out_of_range);
+    CHECK(metrics.total() == 3 && xt::sum(metrics.confusion())() == 3);
+}
+
+//softmax against the textbook formula with std::exp, along every axis
+static xt::xarray<double> softmax_reference(const xt::xarray<double>& X, int axis){
+    int last = X.dimension() - 1;
+    xt::xarray<double> Y = xt::swapaxes(X, axis, last);
+    size_t cols = Y.shape()[last];
+    for(size_t start=0; start < Y.size(); start += cols){
+        double* row = Y.data() + start;
+        double xmax = *std::max_element(row, row + cols), sum = 0;
+        for(size_t c=0; c < cols; c++){ row[c] = std::exp(row[c] - xmax); sum += row[c]; }
+        for(size_t c=0; c < cols; c++) row[c] /= sum;
+    }
+    return xt::swapaxes(Y, axis, last);
+}
+
+static double max_relative_error(const xt::xarray<double>& actual, const xt::xarray<double>& expected){
+    return xt::amax(xt::abs(actual - expected)/xt::maximum(xt::abs(expected), 1e-300))();
+}
+
+static void test_softmax(){
+    vector<vector<size_t>> shapes = {{1}, {7}, {5, 1}, {3, 9}, {64, 130}, {2, 3, 5}, {4, 6, 11}};
+    for(vector<size_t>& shape: shapes){
+        xt::xarray<double> X = 30.0*xt::random::randn<double>(shape);
+        for(int axis=0; axis < (int)shape.size(); axis++){
+            xt::xarray<double> expected = softmax_reference(X, axis);
+            xt::xarray<double> Y = softmax(X, axis);
+            CHECK(Y.shape() == X.shape());
+            CHECK(max_relative_error(Y, expected) < 1e-12);
+            CHECK(max_relative_error(softmax(X, axis - (int)shape.size()), expected) < 1e-12);
+            //softmax_into keeps the output buffer when the shape already fits
+            const double* before = Y.data();
+            softmax_into(X, Y, axis);
+            CHECK(Y.data() == before && max_relative_error(Y, expected) < 1e-12);
+            xt::xarray<double> Z = xt::zeros<double>({2});
+            softmax_into(X, Z, axis);
+            CHECK(max_relative_error(Z, expected) < 1e-12);
+        }
+    }
+    //huge logits do not overflow; tiny differences are not lost
+    xt::xarray<double> big = {{1000.0, 999.0, -1000.0}, {1e-12, 0.0, 0.0}};
+    CHECK(max_relative_error(softmax(big), softmax_reference(big, 1)) < 1e-12);
+    CHECK_THROWS(softmax(xt::xarray<double>(3.0), 0), std::invalid_argument);
+    CHECK_THROWS(softmax(xt::xarray<double>({1.0, 2.0}), 1), std::out_of_range);
+}
+
+//-inf masks a logit out: its probability is exactly 0, the rest share the mass
+static void test_softmax_masked_logits(){
+    const double MASK = -std::numeric_limits<double>::infinity();
+    xt::xarray<double> X = {{2.0, MASK, 0.5, MASK, -1.0}, {MASK, 3.0, MASK, MASK, MASK},
+                            {-800.0, 0.0, -720.0, MASK, 1.0}};
+    xt::xarray<double> Y = softmax(X);
+    CHECK(Y(0, 1) == 0 && Y(0, 3) == 0);
+    CHECK(Y(1, 0) == 0 && Y(1, 1) == 1 && Y(1, 4) == 0);
+    CHECK(Y(2, 3) == 0);
+    CHECK(xt::amax(xt::abs(xt::sum(Y, {1}) - 1.0))() < 1e-15);
+    xt::xarray<double> unmasked = {2.0, 0.5, -1.0};
+    xt::xarray<double> expected = softmax_reference(unmasked, 0);
+    CHECK(std::abs(Y(0, 0) - expected(0)) < 1e-14 && std::abs(Y(0, 4) - expected(2)) < 1e-14);
+    xt::xarray<double> Z;
+    softmax_into(xt::xarray<double>(xt::transpose(X)), Z, 0);
+    CHECK(xt::amax(xt::abs(Z - xt::transpose(Y)))() < 1e-15);
+}
+
+//stack kernels against a per-entry xt::linalg reference
+static void test_stack_kernels(){
+    size_t N = 6, A = 5, B = 7, C = 3;
+    xt::xarray<double> X = xt::random::randn<double>({N, A}), Y = xt::random::randn<double>({N, B});
+    xt::xarray<double> outer = outer_stack(X, Y), diag = diag_stack(Y);
+    CHECK(outer.shape() == (xt::xarray<double>::shape_type{N, A, B}));
+    CHECK(diag.shape() == (xt::xarray<double>::shape_type{N, B, B}));
+    xt::xarray<double> M = xt::random::randn<double>({N, A, B}), R = xt::random::randn<double>({N, B, C});
+    xt::xarray<double> MY = matmul_on_stack(M, Y), MR = matmul_on_stack(M, R);
+    CHECK(MY.shape() == (xt::xarray<double>::shape_type{N, A}));
+    CHECK(MR.shape() == (xt::xarray<double>::shape_type{N, A, C}));
+
+    xt::xarray<double> P = softmax(xt::random::randn<double>({N, B})), DP = xt::random::randn<double>({N, B});
+    xt::xarray<double> jacobian_dot = softmax_jacobian_dot(P, DP);
+    for(size_t n=0; n < N; n++){
+        xt::xarray<double> x = xt::view(X, n), y = xt::view(Y, n), p = xt::view(P, n);
+        xt::xarray<double> m = xt::view(M, n), r = xt::view(R, n);
+        CHECK(xt::amax(xt::abs(xt::view(outer, n) - xt::linalg::outer(x, y)))() < 1e-12);
+        CHECK(xt::amax(xt::abs(xt::view(diag, n) - xt::diag(y)))() == 0);
+        CHECK(xt::amax(xt::abs(xt::view(MY, n) - xt::linalg::dot(m, y)))() < 1e-12);
+        CHECK(xt::amax(xt::abs(xt::view(MR, n) - xt::linalg::dot(m, r)))() < 1e-12);
+        //the full Jacobian diag(p) - p p^T times dp
+        xt::xarray<double> J = xt::diag(p) - xt::linalg::outer(p, p);
+        CHECK(xt::amax(xt::abs(xt::view(jacobian_dot, n) - xt::linalg::dot(J, xt::view(DP, n))))() < 1e-12);
+    }
+    CHECK_THROWS(outer_stack(X, xt::random::randn<double>({N + 1, B})), std::invalid_argument);
+    CHECK_THROWS(diag_stack(M), std::invalid_argument);
+    CHECK_THROWS(matmul_on_stack(M, X), std::invalid_argument);
+    CHECK_THROWS(matmul_on_stack(M, xt::random::randn<double>({N, A, C})), std::invalid_argument);
+    CHECK_THROWS(softmax_jacobian_dot(P, X), std::invalid_argument);
+}
+
+//a model evaluated layer by layer with xt::linalg::dot and the softmax reference
+static xt::xarray<double> predict_reference(BaseModel* model, xt::xarray<double> X){
+    for(int idx=0; idx < model->num_layers(); idx++){
+        Layer* layer = model->get_layer(idx);
+        if(FCLayer* fc = dynamic_cast<FCLayer*>(layer)){
+            size_t n_in = fc->get_in_features(), n_out = fc->get_out_features();
+            xt::xarray<double> W = xt::adapt(fc->weights_data(), n_out*n_in, xt::no_ownership(),
+                                             vector<size_t>{n_out, n_in});
+            X = xt::linalg::dot(X, xt::transpose(W));
+            if(fc->get_use_bias())
+                X += xt::adapt(fc->bias_data(), n_out, xt::no_ownership(), vector<size_t>{n_out});
+        }
+        else if(dynamic_cast<ReLU*>(layer) != nullptr) X = xt::maximum(X, 0.0);
+        else if(Softmax* sm = dynamic_cast<Softmax*>(layer)) X = softmax_reference(X, sm->get_axis());
+    }
+    return X;
+}
+
+//predict(X, ctx) from several threads at once, each with its own context
+static void test_reentrant_predict(){
+    Layer* seq[] = {new FCLayer(16, 32), new ReLU(), new FCLayer(32, 32), new ReLU(),
+                    new FCLayer(32, 5, false), new Softmax()};
+    BaseModel model(seq, 6);
+    model.eval();
+    vector<xt::xarray<double>> inputs, expected;
+    for(size_t batch: {1, 3, 8, 33}){
+        inputs.push_back(xt::random::randn<double>({batch, (size_t)16}));
+        expected.push_back(predict_reference(&model, inputs.back()));
+    }
+    vector<std::thread> threads;
+    for(int t=0; t < 4; t++) threads.emplace_back([&, t]{
+        InferenceContext ctx;
+        for(int i=0; i < 100; i++){
+            size_t which = (t + i)%inputs.size();
+            const xt::xarray<double>& Y = model.predict(inputs[which], ctx);
+            CHECK(Y.shape() == expected[which].shape());
+            CHECK(xt::amax(xt::abs(Y - expected[which]))() < 1e-12);
+        }
+        //the same batch shape again reuses the context's buffers
+        const double* before = model.predict(inputs[0], ctx).data();
+        CHECK(model.predict(inputs[0], ctx).data() == before);
+    });
+    for(std::thread& thread: threads) thread.join();
+    CHECK(xt::amax(xt::abs(model.predict(inputs[3]) - expected[3]))() < 1e-12);
+
+    BaseModel empty;
+    InferenceContext ctx;
+    CHECK(empty.predict(inputs[1], ctx) == inputs[1]);
+}
+
+//CSR input: same results as the dense path, from the matrix and through SparseDataLoader
+static void test_sparse_predict(){
+    mt19937 rng(34);
+    size_t N = 50, D = 40;
+    xt::xarray<double> X = xt::zeros<double>({N, D});
+    for(size_t n=0; n < N; n++)
+        for(size_t d=0; d < D; d++) if(rng()%20 == 0) X(n, d) = xt::random::randn<double>({1})(0);
+    xt::row(X, 7) = 0.0;    //an empty row
+    CSRMatrix csr = CSRMatrix::fromDense(X);
+    CHECK(csr.rows() == N && csr.cols() == D);
+    CHECK(csr.nnz() == (size_t)xt::sum(xt::not_equal(X, 0.0))());
+    CHECK(csr.toDense() == X);
+
+    Layer* seq[] = {new FCLayer(D, 12), new ReLU(), new FCLayer(12, 4), new Softmax()};
+    BaseModel model(seq, 4);
+    model.eval();
+    xt::xarray<double> expected = predict_reference(&model, X);
+    CHECK(xt::amax(xt::abs(model.predict(csr) - expected))() < 1e-12);
+    CHECK(xt::amax(xt::abs(model.predict(X) - expected))() < 1e-12);
+    CHECK_THROWS(model.predict(CSRMatrix::fromDense(xt::ones<double>({(size_t)2, D + 1}))), std::invalid_argument);
+
+    //a first layer that is not an FCLayer takes the densified batch
+    Layer* relu_first[] = {new ReLU(), new FCLayer(D, 3, false)};
+    BaseModel densified(relu_first, 2);
+    densified.eval();
+    CHECK(xt::amax(xt::abs(densified.predict(csr) - predict_reference(&densified, X)))() < 1e-12);
+
+    xt::xarray<int> labels = xt::arange<int>(N);
+    SparseTensorDataset<int> dataset(csr, labels);
+    SparseDataLoader<int> loader(&dataset, 16, false);
+    size_t seen = 0;
+    for(auto batch: loader){
+        CSRMatrix& rows = batch.getData();
+        xt::xarray<int>& batch_labels = batch.getLabel();
+        CHECK(rows.cols() == D && batch_labels.size() == rows.rows());
+        for(size_t r=0; r < rows.rows(); r++) CHECK(batch_labels(r) == (int)(seen + r));
+        xt::xarray<double> Y = model.predict(rows);
+        for(size_t r=0; r < rows.rows(); r++)
+            CHECK(xt::amax(xt::abs(xt::row(Y, r) - xt::row(expected, seen + r)))() < 1e-12);
+        seen += rows.rows();
+    }
+    CHECK(seen == N);
+    xt::xarray<double> item = dataset.getitem(3).getData();
+    CHECK(item == xt::xarray<double>(xt::row(X, 3)));
+}
+
+//confusion counts and metrics against a naive count over the samples
+static ulong_array random_labels(mt19937& rng, size_t n, ulong nclasses){
+    ulong_array labels = xt::zeros<ulong>({n});
+    for(size_t idx=0; idx < n; idx++) labels[idx] = rng()%nclasses;
+    return labels;
+}
+
+static void check_confusion(const ulong_array& y_true, const ulong_array& y_pred, int nthreads){
+    map<pair<ulong, ulong>, ulong> naive;
+    map<ulong, ulong> support;
+    ulong nclasses = 0;
+    for(size_t idx=0; idx < y_true.size(); idx++){
+        naive[{y_true[idx], y_pred[idx]}]++;
+        support[y_true[idx]]++;
+        nclasses = std::max(nclasses, std::max(y_true[idx], y_pred[idx]) + 1);
+    }
+    ulong_array counts;
+    ulong_array confusion = confusion_matrix(y_true, y_pred, &counts, nthreads);
+    CHECK(confusion.shape()[0] == nclasses && confusion.shape()[1] == nclasses);
+    CHECK(xt::sum(confusion)() == y_true.size());
+    for(auto& cell: naive) CHECK(confusion(cell.first.first, cell.first.second) == cell.second);
+    CHECK(counts.size() == nclasses);
+    for(ulong k=0; k < nclasses; k++) CHECK(counts[k] == support[k]);
+    CHECK(class_count(confusion) == counts);
+
+    SparseConfusion sparse = confusion_matrix_sparse(y_true, y_pred);
+    CHECK(sparse.nnz() == naive.size());
+    for(auto& cell: naive) CHECK(sparse.get(cell.first.first, cell.first.second) == cell.second);
+    CHECK(sparse.to_dense() == confusion);
+    CHECK(class_count(sparse) == counts);
+}
+
+static void test_confusion_matrix(){
+    mt19937 rng(9);
+    ulong_array y_true = random_labels(rng, 1000, 7), y_pred = random_labels(rng, 1000, 7);
+    check_confusion(y_true, y_pred, 0);
+    //mostly correct predictions, so the diagonal dominates
+    y_true = random_labels(rng, 200000, 10);
+    y_pred = y_true;
+    for(size_t idx=0; idx < y_pred.size(); idx += 3) y_pred[idx] = rng()%10;
+    check_confusion(y_true, y_pred, 4);     //private histograms
+    y_true = random_labels(rng, 200000, 3000);
+    y_pred = random_labels(rng, 200000, 3000);
+    check_confusion(y_true, y_pred, 4);     //3000 x 3000 is past the budget: row bands
+    CHECK_THROWS(confusion_matrix(ulong_array({1, 2}), ulong_array({1})), std::invalid_argument);
+}
+
+static void test_calc_metrics(){
+    mt19937 rng(10);
+    for(ulong nclasses: {2ul, 5ul, 2500ul}){
+        ulong_array y_true = random_labels(rng, 20000, nclasses), y_pred = y_true;
+        for(size_t idx=0; idx < y_pred.size(); idx += 2) y_pred[idx] = rng()%nclasses;
+        vector<double> tp(nclasses, 0), support(nclasses, 0), predicted(nclasses, 0);
+        for(size_t idx=0; idx < y_true.size(); idx++){
+            support[y_true[idx]]++;
+            predicted[y_pred[idx]]++;
+            if(y_true[idx] == y_pred[idx]) tp[y_true[idx]]++;
+        }
+        double expected[NUM_CLASS_METRICS] = {0};
+        double total = y_true.size();
+        for(ulong k=0; k < nclasses; k++){
+            double precision = predicted[k] > 0? tp[k]/predicted[k] : 0;
+            double recall = support[k] > 0? tp[k]/support[k] : 0;
+            double f1 = precision + recall > 0? 2*precision*recall/(precision + recall) : 0;
+            expected[ACCURACY] += tp[k]/total;
+            expected[PRECISION_MACRO] += precision/nclasses;
+            expected[RECALL_MACRO] += recall/nclasses;
+            expected[F1_MEASURE_MACRO] += f1/nclasses;
+            expected[PRECISION_WEIGHTED] += support[k]/total*precision;
+            expected[RECALL_WEIGHTED] += support[k]/total*recall;
+            expected[F1_MEASURE_WEIGHTED] += support[k]/total*f1;
+        }
+        //above SPARSE_CONFUSION_THRESHOLD classes this goes through SparseConfusion
+        double_array metrics = calc_metrics(y_true, y_pred);
+        double_array dense = calc_metrics(confusion_matrix(y_true, y_pred));
+        for(int m=0; m < NUM_CLASS_METRICS; m++){
+            CHECK(std::abs(metrics[m] - expected[m]) < 1e-9);
+            CHECK(std::abs(dense[m] - expected[m]) < 1e-9);
+        }
+    }
+    CHECK_THROWS(calc_metrics(ulong_array(xt::zeros<ulong>({2, 3}))), std::invalid_argument);
+}
+
+void test_ann(TestHarness& harness){
+    harness.run("ann/checkpoint/round_trip", test_checkpoint_round_trip);
+    harness.run("ann/checkpoint/corrupt_records", test_checkpoint_corrupt_records);
+    harness.run("ann/FCLayer/from_pretrained", test_fc_from_pretrained);
+    harness.run("ann/InferenceEngine/batched_predict", test_inference_engine);
+    harness.run("ann/BaseModel/reentrant_predict", test_reentrant_predict);
+    harness.run("ann/BaseModel/profiling_toggle", test_profiling_toggle);
+    harness.run("ann/BaseModel/sparse_predict", test_sparse_predict);
+    harness.run("ann/MetricsAccumulator/batch_is_atomic", test_metrics_batch_is_atomic);
+    harness.run("ann/softmax/vs_std_exp", test_softmax);
+    harness.run("ann/softmax/masked_logits", test_softmax_masked_logits);
+    harness.run("ann/xtensor_lib/stack_kernels", test_stack_kernels);
+    harness.run("ann/metrics/confusion_matrix", test_confusion_matrix);
+    harness.run("ann/metrics/calc_metrics", test_calc_metrics);
+}
@@ -0,0 +1,208 @@
+/*
+ * File:   test_concurrent.cpp
+ *
+ * Stress tests for ConcurrentXArrayList and the MPMC / SPSC queues. They
+ * pass in any build, but are meant to be run under the tsan preset:
+ *
+ *   cmake --preset tsan && cmake --build --preset tsan && ctest --preset tsan
+ */
+
+#include "harness.h"
+#include "list/ConcurrentXArrayList.h"
+#include "list/ConcurrentQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+//concurrent add from several threads while another thread reads the newest items
+static void test_concurrent_append(){
+    const int nthreads = 4, per_thread = 10000;
+    ConcurrentXArrayList<string> list;
+    std::atomic<bool> done(false);
+    std::thread reader([&]{
+        while(!done.load()){
+            int n = list.size();
+            if(n > 0) CHECK(!list.get(n - 1).empty() && !list.get(0).empty());
+        }
+    });
+    vector<vector<int>> indices(nthreads);
+    vector<std::thread> writers;
+    for(int t=0; t < nthreads; t++) writers.emplace_back([&, t]{
+        for(int i=0; i < per_thread; i++)
+            indices[t].push_back(list.add(to_string(t) + ":" + to_string(i)));
+    });
+    for(std::thread& writer: writers) writer.join();
+    done = true;
+    reader.join();
+
+    CHECK(list.size() == nthreads*per_thread);
+    vector<int> all;
+    for(int t=0; t < nthreads; t++){
+        for(int i=0; i < per_thread; i++){
+            CHECK(list.get(indices[t][i]) == to_string(t) + ":" + to_string(i));
+            all.push_back(indices[t][i]);
+        }
+    }
+    std::sort(all.begin(), all.end());
+    for(int i=0; i < (int)all.size(); i++) CHECK(all[i] == i);
+
+    //blocks never move: references stay valid across later adds
+    string* fifth = &list.get(5);
+    list.add("x");
+    CHECK(fifth == &list.get(5));
+}
+
+//an item whose move-assignment throws for one value
+struct ThrowingItem {
+    int value = 0;
+    ThrowingItem() {}
+    ThrowingItem(int value): value(value) {}
+    ThrowingItem(const ThrowingItem& other): value(other.value) {}
+    ThrowingItem& operator=(ThrowingItem&& other){
+        if(other.value < 0) throw std::runtime_error("cannot store a negative item");
+        value = other.value;
+        return *this;
+    }
+    bool operator==(const ThrowingItem& other) const { return value == other.value; }
+};
+
+static void test_concurrent_append_failure(){
+    ConcurrentXArrayList<ThrowingItem> list;
+    for(int i=0; i < 10; i++){
+        if(i == 5) CHECK_THROWS(list.add(ThrowingItem(-1)), std::runtime_error);
+        else list.add(ThrowingItem(i));
+    }
+    //the failed index stays claimed, but reading it throws instead of waiting forever
+    CHECK(list.size() == 10);
+    CHECK(!list.isReady(5) && list.isReady(6));
+    CHECK_THROWS(list.get(5), std::runtime_error);
+    CHECK(list.get(9).value == 9);
+}
+
+//P producers, C consumers; every item arrives exactly once and in per-producer order
+template <class Q>
+static void run_queue(int nproducers, int nconsumers, int per_producer, int capacity, bool batch){
+    Q queue(capacity);
+    const int total = nproducers*per_producer;
+    std::atomic<long long> sum(0);
+    std::atomic<int> received(0);
+    vector<vector<int>> seen(nconsumers);
+    vector<std::thread> threads;
+    for(int p=0; p < nproducers; p++) threads.emplace_back([&, p]{
+        if(batch){
+            int items[7];
+            for(int i=0; i < per_producer; i += 7){
+                int n = std::min(7, per_producer - i);
+                for(int k=0; k < n; k++) items[k] = p*per_producer + i + k;
+                for(int off=0; off < n;){
+                    int pushed = queue.pushBatch(items + off, n - off);
+                    off += pushed;
+                    if(pushed == 0) std::this_thread::yield();
+                }
+            }
+        }
+        else for(int i=0; i < per_producer; i++){
+            int item = p*per_producer + i;
+            if(i%3 == 0) queue.push(item);
+            else if(i%3 == 1){ while(!queue.tryPushFor(item, std::chrono::microseconds(50))); }
+            else while(!queue.tryPush(item)) std::this_thread::yield();
+        }
+    });
+    for(int c=0; c < nconsumers; c++) threads.emplace_back([&, c]{
+        int items[5];
+        while(received.load() < total){
+            if(batch){
+                int n = queue.popBatch(items, 5);
+                for(int k=0; k < n; k++){ sum += items[k]; seen[c].push_back(items[k]); }
+                received += n;
+                if(n == 0) std::this_thread::yield();
+            }
+            else{
+                int item;
+                if(queue.tryPopFor(item, std::chrono::milliseconds(1))){
+                    sum += item;
+                    seen[c].push_back(item);
+                    received++;
+                }
+            }
+        }
+    });
+    for(std::thread& thread: threads) thread.join();
+
+    CHECK(received.load() == total);
+    CHECK(sum.load() == (long long)total*(total - 1)/2);
+    for(vector<int>& items: seen){
+        vector<int> last(nproducers, -1);
+        for(int item: items){
+            CHECK(item > last[item/per_producer]);
+            last[item/per_producer] = item;
+        }
+    }
+    CHECK(queue.empty());
+}
+
+static void test_mpmc_stress(){
+    run_queue<MPMCQueue<int>>(3, 3, 10000, 8, false);
+    run_queue<MPMCQueue<int>>(3, 2, 10000, 16, true);
+    run_queue<MPMCQueue<int>>(1, 1, 20000, 2, false);
+}
+
+static void test_spsc_stress(){
+    run_queue<SPSCQueue<int>>(1, 1, 20000, 4, false);
+    run_queue<SPSCQueue<int>>(1, 1, 20000, 16, true);
+}
+
+//a consumer asleep on an empty queue and a producer asleep on a full one are both woken
+static void test_queue_blocking(){
+    MPMCQueue<string> queue(2);
+    std::thread consumer([&]{
+        for(int i=0; i < 1000; i++) CHECK(queue.pop() == to_string(i));
+    });
+    for(int i=0; i < 1000; i++){
+        if(i%100 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        queue.push(to_string(i));
+    }
+    consumer.join();
+    CHECK(queue.empty());
+
+    SPSCQueue<int> spsc(2);
+    int item;
+    CHECK(!spsc.tryPopFor(item, std::chrono::milliseconds(2)));
+    CHECK(spsc.tryPush(1) && spsc.tryPush(2) && !spsc.tryPush(3));
+    CHECK(!spsc.tryPushFor(3, std::chrono::milliseconds(2)));
+    CHECK_THROWS(MPMCQueue<int>(0), std::invalid_argument);
+}
+
+//an empty or negative batch moves nothing and returns at once, full or empty queue alike
+template <class Q>
+static void check_empty_batches(){
+    Q queue(4);
+    int items[4] = {1, 2, 3, 4};
+    CHECK(queue.pushBatch(items, 0) == 0 && queue.popBatch(items, 0) == 0);
+    CHECK(queue.pushBatch(items, 2) == 2);
+    CHECK(queue.pushBatch(items, 0) == 0 && queue.pushBatch(items, -1) == 0);
+    CHECK(queue.popBatch(items, 0) == 0 && queue.popBatch(items, -1) == 0);
+    CHECK(queue.pushBatch(items, 4) == 2);
+    CHECK(queue.pushBatch(items, 0) == 0);
+    CHECK(queue.popBatch(items, 4) == 4);
+    CHECK(items[0] == 1 && items[1] == 2 && items[2] == 1 && items[3] == 2);
+    CHECK(queue.empty());
+}
+
+static void test_queue_empty_batches(){
+    check_empty_batches<MPMCQueue<int>>();
+    check_empty_batches<SPSCQueue<int>>();
+}
+
+void test_concurrent(TestHarness& harness){
+    harness.run("concurrent/ConcurrentXArrayList/append", test_concurrent_append);
+    harness.run("concurrent/ConcurrentXArrayList/append_failure", test_concurrent_append_failure);
+    harness.run("concurrent/MPMCQueue/stress", test_mpmc_stress);
+    harness.run("concurrent/SPSCQueue/stress", test_spsc_stress);
+    harness.run("concurrent/queues/blocking", test_queue_blocking);
+    harness.run("concurrent/queues/empty_batches", test_queue_empty_batches);
+}
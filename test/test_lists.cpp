@@ -0,0 +1,680 @@
+/*
+ * File:   test_lists.cpp
+ *
+ * XArrayList, XSmallList, XDeque, XHeap, DLinkedList, IntrusiveDLinkedList
+ * and PersistentList against the standard containers, under random
+ * operation sequences with fixed seeds.
+ */
+
+#include "harness.h"
+#include "list/IntrusiveDLinkedList.h"
+#include "list/listheader.h"
+#include "list/PersistentList.h"
+#include "list/XDeque.h"
+#include "list/XHeap.h"
+#include "list/XSmallList.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+template <class L>
+static vector<int> items_of(L& list){
+    vector<int> items;
+    for(auto it = list.begin(); it != list.end(); it++) items.push_back(*it);
+    return items;
+}
+
+//every get(i), so both halves of a DLinkedList (head- and tail-side walks) are read
+static bool matches(DLinkedList<int>& list, const vector<int>& expected){
+    if(list.size() != (int)expected.size() || items_of(list) != expected) return false;
+    for(int i=0; i < list.size(); i++) if(list.get(i) != expected[i]) return false;
+    return true;
+}
+
+static DLinkedList<int>::Iterator iterator_at(DLinkedList<int>& list, int index){
+    DLinkedList<int>::Iterator it = list.begin();
+    while(index-- > 0) it++;
+    return it;
+}
+
+//XArrayList growth: the capacity after each reallocation follows the policy
+template <class T>
+static void check_growth(xarray_growth policy, int chunk, T (*make)(int)){
+    XArrayList<T> list(0, 0, 4);
+    list.setGrowthPolicy(policy, chunk);
+    CHECK(list.getGrowthPolicy() == policy);
+    vector<T> ref;
+    int expected = 4;
+    for(int i=0; i < 3000; i++){
+        if(i == expected){
+            if(policy == XARRAY_GROW_DOUBLE) expected *= 2;
+            else if(policy == XARRAY_GROW_HALF) expected += expected/2;
+            else expected += chunk;
+        }
+        if(i%5 == 4){ list.add(i/2, make(i)); ref.insert(ref.begin() + i/2, make(i)); }
+        else{ list.add(make(i)); ref.push_back(make(i)); }
+        CHECK(list.getCapacity() == expected);
+    }
+    for(int i=0; i < (int)ref.size(); i++) CHECK(list.get(i) == ref[i]);
+
+    list.reserve(100);
+    CHECK(list.getCapacity() == expected);
+    list.reserve(expected + 7);
+    CHECK(list.getCapacity() == expected + 7);
+    for(int i=0; i < 2000; i++){ list.removeAt(0); ref.erase(ref.begin()); }
+    list.shrink_to_fit();
+    CHECK(list.getCapacity() == 1000 && list.size() == 1000);
+    for(int i=0; i < (int)ref.size(); i++) CHECK(list.get(i) == ref[i]);
+    XArrayList<T> copy(list);
+    CHECK(copy.size() == 1000 && copy.get(999) == ref[999]);
+    list.clear();
+    list.shrink_to_fit();
+    CHECK(list.size() == 0 && list.getCapacity() == 1);
+    list.add(make(1));
+    CHECK(list.get(0) == make(1));
+}
+
+static int make_int(int i){ return i; }
+static string make_string(int i){ return "item " + to_string(i); }
+
+static void test_arraylist_growth(){
+    check_growth<int>(XARRAY_GROW_DOUBLE, 1024, make_int);
+    check_growth<int>(XARRAY_GROW_HALF, 1024, make_int);
+    check_growth<int>(XARRAY_GROW_CHUNK, 100, make_int);
+    check_growth<string>(XARRAY_GROW_DOUBLE, 1024, make_string);
+    check_growth<string>(XARRAY_GROW_HALF, 1024, make_string);
+    check_growth<string>(XARRAY_GROW_CHUNK, 64, make_string);
+    XArrayList<int> list;
+    CHECK_THROWS(list.setGrowthPolicy(XARRAY_GROW_CHUNK, 0), std::invalid_argument);
+    list.clear();
+    CHECK(list.getCapacity() == 10);
+}
+
+//XArrayList sort / stableSort / radixSort against std::sort and std::stable_sort,
+//below and above LIST_PARALLEL_SORT_THRESHOLD
+struct Keyed {
+    int key;
+    int seq;
+    bool operator==(const Keyed& other) const { return key == other.key && seq == other.seq; }
+};
+
+static ostream& operator<<(ostream& os, const Keyed& item){ return os << item.key << "#" << item.seq; }
+
+static bool longer_first(string& lhs, string& rhs){
+    return lhs.size() != rhs.size()? lhs.size() > rhs.size() : lhs < rhs;
+}
+
+static void test_arraylist_sort(){
+    mt19937 rng(41);
+    const int sizes[] = {0, 1, 2, 100, LIST_RADIX_SORT_MIN_SIZE + 1, 5000, LIST_PARALLEL_SORT_THRESHOLD + 12345};
+    for(int n: sizes){
+        vector<int> ints(n);
+        vector<double> doubles(n);
+        vector<Keyed> keyed(n);
+        for(int i=0; i < n; i++){
+            ints[i] = (int)(rng() - (1u << 31));
+            doubles[i] = (i%7 == 0)? -0.5*(rng()%1000) : 1e-3*(int)(rng()%200001 - 100000);
+            keyed[i] = Keyed{(int)(rng()%50) - 25, i};
+        }
+        XArrayList<int> a, b, c;
+        XArrayList<double> d;
+        XArrayList<Keyed> stable, radix;
+        for(int i=0; i < n; i++){
+            a.add(ints[i]); b.add(ints[i]); c.add(ints[i]);
+            d.add(doubles[i]);
+            stable.add(keyed[i]); radix.add(keyed[i]);
+        }
+        a.sort();
+        b.stableSort([](const int& lhs, const int& rhs){ return lhs > rhs; });
+        c.radixSort();
+        d.radixSort();
+        stable.stableSort([](const Keyed& lhs, const Keyed& rhs){ return lhs.key < rhs.key; });
+        radix.radixSort([](const Keyed& item){ return item.key; });
+
+        vector<int> ascending = ints, descending = ints;
+        std::sort(ascending.begin(), ascending.end());
+        std::sort(descending.begin(), descending.end(), std::greater<int>());
+        std::sort(doubles.begin(), doubles.end());
+        std::stable_sort(keyed.begin(), keyed.end(),
+                         [](const Keyed& lhs, const Keyed& rhs){ return lhs.key < rhs.key; });
+        CHECK(a.size() == n && b.size() == n && c.size() == n);
+        bool same = true;
+        for(int i=0; i < n; i++){
+            same = same && a.get(i) == ascending[i] && b.get(i) == descending[i];
+            same = same && c.get(i) == ascending[i] && d.get(i) == doubles[i];
+            same = same && stable.get(i) == keyed[i] && radix.get(i) == keyed[i];
+        }
+        CHECK(same);
+    }
+
+    //the chunked merge itself, whatever the machine's core count: odd worker
+    //counts leave a run to carry over, and the stable variant keeps ties in order
+    for(int nthreads: {2, 3, 5, 8}){
+        const int n = 40000 + nthreads;
+        vector<Keyed> ref(n);
+        for(int i=0; i < n; i++) ref[i] = Keyed{(int)(rng()%1000), i};
+        vector<Keyed> unstable = ref, stable = ref;
+        auto by_key = [](const Keyed& lhs, const Keyed& rhs){ return lhs.key < rhs.key; };
+        list_parallel_sort(unstable.data(), n, by_key, false, nthreads);
+        list_parallel_sort(stable.data(), n, by_key, true, nthreads);
+        std::stable_sort(ref.begin(), ref.end(), by_key);
+        CHECK(stable == ref);
+        bool same_keys = true;
+        for(int i=0; i < n; i++) same_keys = same_keys && unstable[i].key == ref[i].key;
+        CHECK(same_keys);
+    }
+
+    //strings, with an itemEqual-style comparator, on both sides of the threshold
+    for(int n: {3000, LIST_PARALLEL_SORT_THRESHOLD + 1}){
+        vector<string> ref;
+        XArrayList<string> list;
+        for(int i=0; i < n; i++){
+            string item = make_string(rng()%100000).substr(0, 5 + rng()%8);
+            ref.push_back(item);
+            list.add(item);
+        }
+        list.sort(longer_first);
+        std::sort(ref.begin(), ref.end(), longer_first);
+        bool same = true;
+        for(int i=0; i < n; i++) same = same && list.get(i) == ref[i];
+        CHECK(same);
+    }
+}
+
+//XArrayList::subList / asSpan: views of the list's own items, checked against vector slices
+static bool same_case(string& lhs, string& rhs){
+    if(lhs.size() != rhs.size()) return false;
+    for(size_t i=0; i < lhs.size(); i++) if(tolower(lhs[i]) != tolower(rhs[i])) return false;
+    return true;
+}
+
+static void test_arraylist_span(){
+    mt19937 rng(50);
+    XArrayList<int> list;
+    vector<int> ref;
+    for(int i=0; i < 200; i++){ int item = rng()%50; list.add(item); ref.push_back(item); }
+    for(int round=0; round < 500; round++){
+        int from = rng()%(ref.size() + 1), to = from + rng()%(ref.size() - from + 1);
+        XArraySpan<int> span = list.subList(from, to);
+        CHECK(span.size() == to - from && span.empty() == (from == to));
+        CHECK(span.data() == &list.get(0) + from);
+        CHECK(std::equal(span.begin(), span.end(), ref.begin() + from, ref.begin() + to));
+        int item = rng()%50;
+        auto found = std::find(ref.begin() + from, ref.begin() + to, item);
+        CHECK(span.indexOf(item) == (found == ref.begin() + to? -1 : (int)(found - ref.begin()) - from));
+        CHECK(span.contains(item) == (found != ref.begin() + to));
+        if(from < to){
+            //writes through the view land in the list
+            int i = rng()%(to - from);
+            span.get(i) = span[i] + 1000;
+            ref[from + i] += 1000;
+            CHECK(list.get(from + i) == ref[from + i]);
+            int a = rng()%(to - from), b = a + rng()%(to - from - a + 1);
+            XArraySpan<int> inner = span.subSpan(a, b);
+            CHECK(inner.data() == span.data() + a && inner.size() == b - a);
+            CHECK_THROWS(span.get(to - from), std::out_of_range);
+            CHECK_THROWS(span.subSpan(0, to - from + 1), std::out_of_range);
+        }
+    }
+    //std algorithms on a view rearrange the list in place
+    std::sort(list.subList(50, 150).begin(), list.subList(50, 150).end());
+    std::sort(ref.begin() + 50, ref.begin() + 150);
+    CHECK(std::equal(list.asSpan().begin(), list.asSpan().end(), ref.begin(), ref.end()));
+    CHECK(list.asSpan().toString() == list.toString());
+
+    CHECK_THROWS(list.subList(-1, 3), std::out_of_range);
+    CHECK_THROWS(list.subList(5, 4), std::out_of_range);
+    CHECK_THROWS(list.subList(0, list.size() + 1), std::out_of_range);
+    CHECK(list.subList(list.size(), list.size()).empty());
+    CHECK_THROWS(XArraySpan<int>(nullptr, 1), std::invalid_argument);
+    CHECK_THROWS(XArraySpan<int>(&ref[0], -1), std::invalid_argument);
+
+    //the list's itemEqual carries over to its views
+    XArrayList<string> names(0, same_case);
+    for(string name: {"Ada", "alan", "GRACE", "edsger"}) names.add(name);
+    XArraySpan<string> tail = names.subList(1, 4);
+    CHECK(tail.indexOf("Grace") == 1 && !tail.contains("ADA"));
+    CHECK(names.asSpan().contains("ADA"));
+}
+
+//XSmallList: inline until it outgrows N, back inline after shrink_to_fit; copies own their storage
+template <class T, int N>
+static void check_small_list(mt19937& rng, T (*make)(int)){
+    for(int round=0; round < 100; round++){
+        XSmallList<T, N> list;
+        vector<T> ref;
+        bool spilled = false;
+        for(int op=0; op < 60; op++){
+            int r = rng()%100, n = ref.size();
+            T item = make(rng()%1000);
+            if(r < 35){ list.add(item); ref.push_back(item); }
+            else if(r < 50){ int i = rng()%(n + 1); list.add(i, item); ref.insert(ref.begin() + i, item); }
+            else if(r < 75 && n){ int i = rng()%n; CHECK(list.removeAt(i) == ref[i]); ref.erase(ref.begin() + i); }
+            else if(r < 80 && n){
+                T victim = ref[rng()%n];
+                CHECK(list.removeItem(victim));
+                ref.erase(std::find(ref.begin(), ref.end(), victim));
+            }
+            else if(r < 85){ list.shrink_to_fit(); spilled = false; }
+            else if(r < 88){
+                int wanted = rng()%(3*N);
+                list.reserve(wanted);
+                spilled = spilled || wanted > N;
+            }
+            else if(r < 92){
+                XSmallList<T, N> copy(list);
+                list.clear();
+                CHECK(list.size() == 0 && list.isInline());
+                list = copy;
+                spilled = !list.isInline();
+            }
+            spilled = spilled || (int)ref.size() > N;
+            CHECK(list.size() == (int)ref.size());
+            if(!spilled) CHECK(list.isInline() && list.getCapacity() == N);
+            if((int)ref.size() > N) CHECK(!list.isInline() && list.getCapacity() >= (int)ref.size());
+        }
+        for(int i=0; i < (int)ref.size(); i++) CHECK(list.get(i) == ref[i]);
+        for(T& item: ref) CHECK(list.indexOf(item) == (int)(std::find(ref.begin(), ref.end(), item) - ref.begin()));
+        //a copy never shares the source's storage, inline or not
+        XSmallList<T, N> copy(list);
+        if(!ref.empty()){
+            copy.get(0) = make(-1);
+            CHECK(list.get(0) == ref[0]);
+        }
+        int idx = 0;
+        for(auto it = list.begin(); it != list.end(); it++) CHECK(*it == ref[idx++]);
+        list.shrink_to_fit();
+        CHECK(list.isInline() == ((int)ref.size() <= N));
+    }
+}
+
+static void test_small_list(){
+    mt19937 rng(39);
+    check_small_list<int, 1>(rng, make_int);
+    check_small_list<int, 4>(rng, make_int);
+    check_small_list<string, 3>(rng, make_string);
+    check_small_list<string, 8>(rng, make_string);
+    XSmallList<int, 2> list;
+    CHECK_THROWS(list.get(0), std::out_of_range);
+    CHECK_THROWS(list.removeAt(0), std::out_of_range);
+}
+
+//XDeque: keep the ring wrapped around the end of its buffer while it is used from both ends
+static void test_deque_wraparound(){
+    XDeque<int> deque(0, 0, 8);
+    std::deque<int> ref;
+    int next = 0;
+    for(int round=0; round < 100; round++){
+        //push 5 at the back, pop 5 at the front: the head walks round the ring
+        for(int k=0; k < 5; k++){ deque.addLast(next); ref.push_back(next); next++; }
+        for(int k=0; k < 5; k++){ CHECK(deque.removeFirst() == ref.front()); ref.pop_front(); }
+        deque.addFirst(-round);
+        ref.push_front(-round);
+    }
+    CHECK(deque.size() == (int)ref.size());
+    int *first, *second;
+    int n1 = deque.firstSegment(first), n2 = deque.secondSegment(second);
+    CHECK(n1 + n2 == deque.size());
+    for(int i=0; i < n1; i++) CHECK(first[i] == ref[i]);
+    for(int i=0; i < n2; i++) CHECK(second[i] == ref[n1 + i]);
+    for(int i=0; i < deque.size(); i++) CHECK(deque.get(i) == ref[i]);
+
+    vector<int> copied(deque.size());
+    deque.copyTo(copied.data());
+    CHECK(std::equal(copied.begin(), copied.end(), ref.begin()));
+    int* linear = deque.linearize();
+    for(int i=0; i < deque.size(); i++) CHECK(linear[i] == ref[i]);
+    CHECK_THROWS(XDeque<int>().removeFirst(), std::out_of_range);
+    //capacities past the largest power of two an int holds are refused, not looped on
+    CHECK_THROWS(deque.reserve(XDEQUE_MAX_CAPACITY + 1), std::length_error);
+    CHECK_THROWS(XDeque<int>(0, 0, INT_MAX), std::length_error);
+    CHECK(deque.size() == (int)ref.size() && deque.get(0) == ref[0]);
+}
+
+static void test_deque_random(){
+    mt19937 rng(3);
+    for(int round=0; round < 50; round++){
+        XDeque<string> deque(0, 0, rng()%5);
+        std::deque<string> ref;
+        for(int op=0; op < 400; op++){
+            int r = rng()%100, n = ref.size();
+            string item = to_string(rng()%1000) + string(rng()%20, 'x');
+            if(r < 20){ deque.add(item); ref.push_back(item); }
+            else if(r < 40){ deque.addFirst(item); ref.push_front(item); }
+            else if(r < 50 && n){ CHECK(deque.removeFirst() == ref.front()); ref.pop_front(); }
+            else if(r < 60 && n){ CHECK(deque.removeLast() == ref.back()); ref.pop_back(); }
+            else if(r < 72){ int i = rng()%(n + 1); deque.add(i, item); ref.insert(ref.begin() + i, item); }
+            else if(r < 84 && n){ int i = rng()%n; CHECK(deque.removeAt(i) == ref[i]); ref.erase(ref.begin() + i); }
+            else if(r < 88) deque.shrink_to_fit();
+            else if(r < 92) deque.reserve(rng()%100);
+            else if(r < 94){ XDeque<string> copy(deque); deque = copy; }
+            CHECK(deque.size() == (int)ref.size());
+            CHECK((deque.getCapacity() & (deque.getCapacity() - 1)) == 0);
+        }
+        int i = 0;
+        for(auto it = deque.begin(); it != deque.end(); it++) CHECK(*it == ref[i++]);
+    }
+}
+
+//XHeap: indexed handles through update/remove, checked against a multiset
+template <int D>
+static void test_heap_update_remove(){
+    mt19937 rng(D);
+    for(int round=0; round < 40; round++){
+        XHeap<long, std::less<long>, D> heap(std::less<long>(), true);
+        multiset<long> ref;
+        map<int, long> byHandle;
+        for(int op=0; op < 500; op++){
+            int r = rng()%100;
+            long item = rng()%500;
+            if(r < 40){
+                int handle = heap.push(item);
+                CHECK(handle >= 0 && byHandle.count(handle) == 0);
+                byHandle[handle] = item;
+                ref.insert(item);
+            }
+            else if(r < 55 && !ref.empty()){
+                long top = heap.pop();
+                CHECK(top == *ref.rbegin());
+                ref.erase(std::prev(ref.end()));
+                for(auto it = byHandle.begin(); it != byHandle.end(); ++it)
+                    if(it->second == top && !heap.contains(it->first)){ byHandle.erase(it); break; }
+            }
+            else if(r < 80 && !byHandle.empty()){
+                auto it = byHandle.begin();
+                std::advance(it, rng()%byHandle.size());
+                ref.erase(ref.find(it->second));
+                ref.insert(item);
+                it->second = item;
+                heap.update(it->first, item);
+            }
+            else if(r < 95 && !byHandle.empty()){
+                auto it = byHandle.begin();
+                std::advance(it, rng()%byHandle.size());
+                CHECK(heap.remove(it->first) == it->second);
+                ref.erase(ref.find(it->second));
+                byHandle.erase(it);
+            }
+            CHECK(heap.size() == (int)ref.size());
+            if(!ref.empty()) CHECK(heap.top() == *ref.rbegin());
+        }
+        for(auto& entry: byHandle) CHECK(heap.get(entry.first) == entry.second);
+    }
+    XHeap<int> plain;
+    CHECK_THROWS(plain.pop(), std::out_of_range);
+}
+
+static void test_heap_top_k(){
+    mt19937 rng(11);
+    XHeap<int, std::greater<int>> heap;
+    heap.setBound(10);
+    vector<int> all;
+    for(int i=0; i < 1000; i++){ int item = rng()%100000; heap.push(item); all.push_back(item); }
+    std::sort(all.rbegin(), all.rend());
+    XArrayList<int> top;
+    heap.drain(top);
+    CHECK(top.size() == 10);
+    for(int i=0; i < top.size(); i++) CHECK(top.get(i) == all[9 - i]);
+}
+
+//DLinkedList: splice / split against std::list, including splices within one list
+static void test_dlinkedlist_splice_split(){
+    mt19937 rng(5);
+    for(int round=0; round < 1000; round++){
+        DLinkedList<int> a, b;
+        list<int> ra, rb;
+        int na = rng()%10, nb = rng()%10;
+        for(int i=0; i < na; i++){ a.add(i); ra.push_back(i); }
+        for(int i=0; i < nb; i++){ b.add(100 + i); rb.push_back(100 + i); }
+        int op = rng()%4, p = rng()%(na + 1);
+        auto rpos = ra.begin();
+        std::advance(rpos, p);
+        if(op == 0){
+            a.splice(iterator_at(a, p), b);
+            ra.splice(rpos, rb);
+        }
+        else if(op == 1){
+            int first = rng()%(nb + 1), last = first + rng()%(nb - first + 1);
+            //take the iterators first, then change "b" in front of them
+            DLinkedList<int>::Iterator f = iterator_at(b, first), l = iterator_at(b, last);
+            if(first > 0){ b.add(0, -1); rb.push_front(-1); first++; last++; }
+            a.splice(iterator_at(a, p), b, f, l);
+            auto rf = rb.begin(), rl = rb.begin();
+            std::advance(rf, first);
+            std::advance(rl, last);
+            ra.splice(rpos, rb, rf, rl);
+        }
+        else if(op == 2){
+            a.split(iterator_at(a, p), b);
+            rb.splice(rb.end(), ra, rpos, ra.end());
+        }
+        else if(na >= 2){
+            int first = rng()%na, last = first + rng()%(na - first + 1);
+            do{ p = rng()%(na + 1); } while(p > first && p < last);
+            a.splice(iterator_at(a, p), a, iterator_at(a, first), iterator_at(a, last));
+            auto rp = ra.begin(), rf = ra.begin(), rl = ra.begin();
+            std::advance(rp, p);
+            std::advance(rf, first);
+            std::advance(rl, last);
+            if(p != first && p != last) ra.splice(rp, ra, rf, rl);
+        }
+        CHECK(matches(a, vector<int>(ra.begin(), ra.end())));
+        CHECK(matches(b, vector<int>(rb.begin(), rb.end())));
+    }
+}
+
+static void test_dlinkedlist_sort(){
+    mt19937 rng(7);
+    for(int n: {0, 1, 2, 3, 17, 1000, 4097}){
+        DLinkedList<int> list;
+        vector<int> ref;
+        for(int i=0; i < n; i++){ int item = rng()%50; list.add(item); ref.push_back(item); }
+        list.sort();
+        std::stable_sort(ref.begin(), ref.end());
+        CHECK(matches(list, ref));
+
+        //stability: sort key*10000 + position by key only
+        DLinkedList<int> keyed;
+        for(int i=0; i < n; i++) keyed.add((int)(rng()%10)*10000 + i);
+        keyed.sort([](int& lhs, int& rhs){ return lhs/10000 < rhs/10000; });
+        vector<int> sorted = items_of(keyed);
+        bool stable = std::is_sorted(sorted.begin(), sorted.end());
+        CHECK(stable);
+    }
+    for(int round=0; round < 200; round++){
+        DLinkedList<int> a, b;
+        vector<int> ra, rb, merged;
+        for(int i=rng()%20; i > 0; i--) ra.push_back(rng()%30);
+        for(int i=rng()%20; i > 0; i--) rb.push_back(rng()%30);
+        std::sort(ra.begin(), ra.end());
+        std::sort(rb.begin(), rb.end());
+        for(int item: ra) a.add(item);
+        for(int item: rb) b.add(item);
+        a.mergeSorted(b);
+        std::merge(ra.begin(), ra.end(), rb.begin(), rb.end(), std::back_inserter(merged));
+        CHECK(matches(a, merged) && b.empty());
+    }
+}
+
+static void test_dlinkedlist_cursor(){
+    DLinkedList<int> list;
+    for(int i=0; i < 1000; i++) list.add(i);
+    DLinkedList<int>::Cursor cursor;
+    for(int i=0; i < 1000; i++) CHECK(list.get(i, cursor) == i);
+    for(int i=999; i >= 0; i -= 3) CHECK(list.get(i, cursor) == i);
+    //a change to the list makes the cursor stale; it must not be trusted afterwards
+    list.removeAt(500);
+    CHECK(list.get(500, cursor) == 501);
+    list.add(10, -1);
+    CHECK(list.get(11, cursor) == 10);
+    CHECK(list.get(10, cursor) == -1);
+    DLinkedList<int> other;
+    other.add(7);
+    CHECK(other.get(0, cursor) == 7);
+    CHECK(list.get(11, cursor) == 10);
+}
+
+//a cursor that outlives its list is ignored by a new list built at the same address
+static void test_dlinkedlist_cursor_outlives_list(){
+    DLinkedList<int>::Cursor cursor;
+    for(int round=0; round < 50; round++){
+        DLinkedList<int> list;
+        for(int i=0; i < 100; i++) list.add(round*1000 + i);
+        for(int i=40; i < 60; i++) CHECK(list.get(i, cursor) == round*1000 + i);
+    }
+}
+
+//PersistentList: snapshots keep their content while the list they came from changes
+//IntrusiveDLinkedList: one pool of objects in two lists at once, each mirrored by a std::list of ids
+struct Job {
+    int id;
+    IntrusiveListHook queueHook;
+    IntrusiveListHook allHook;
+    Job(int id = 0): id(id) {}
+};
+
+typedef IntrusiveDLinkedList<Job, &Job::queueHook> JobQueue;
+typedef IntrusiveDLinkedList<Job, &Job::allHook> JobSet;
+
+template <class L>
+static bool same_ids(L& list, const std::list<int>& ids){
+    if(list.size() != (int)ids.size()) return false;
+    auto id = ids.begin();
+    for(auto it = list.begin(); it != list.end(); it++, id++) if(it->id != *id) return false;
+    id = ids.end();
+    for(auto it = list.bbegin(); it != list.bend(); it--) if(it->id != *--id) return false;
+    return true;
+}
+
+template <class L>
+static void random_intrusive_op(mt19937& rng, L& list, std::list<int>& ids, vector<Job>& pool){
+    int n = ids.size(), r = rng()%100;
+    Job* job = &pool[rng()%pool.size()];
+    bool linked = list.contains(job);
+    CHECK(linked == (std::find(ids.begin(), ids.end(), job->id) != ids.end()));
+    if(r < 30){
+        if(linked) CHECK_THROWS(list.add(job), std::invalid_argument);
+        else if(r < 15){ list.add(job); ids.push_back(job->id); }
+        else{ list.addFirst(job); ids.push_front(job->id); }
+    }
+    else if(r < 45 && !linked){
+        int i = rng()%(n + 1);
+        list.add(i, job);
+        ids.insert(std::next(ids.begin(), i), job->id);
+    }
+    else if(r < 60){
+        CHECK(list.remove(job) == linked);
+        if(linked) ids.remove(job->id);
+    }
+    else if(r < 70 && n){
+        int i = rng()%n;
+        auto id = std::next(ids.begin(), i);
+        CHECK(list.removeAt(i)->id == *id);
+        ids.erase(id);
+    }
+    else if(r < 75 && n){ CHECK(list.removeFirst()->id == ids.front()); ids.pop_front(); }
+    else if(r < 80 && n){ CHECK(list.removeLast()->id == ids.back()); ids.pop_back(); }
+    else if(r < 85){
+        //drop every third object through the iterator
+        int k = 0;
+        for(auto it = list.begin(); it != list.end(); it++) if(k++%3 == 0) it.remove();
+        k = 0;
+        for(auto id = ids.begin(); id != ids.end();) id = (k++%3 == 0)? ids.erase(id) : std::next(id);
+    }
+    else if(linked){
+        int i = std::distance(ids.begin(), std::find(ids.begin(), ids.end(), job->id));
+        CHECK(list.indexOf(job) == i && &list.get(i) == job);
+    }
+    else CHECK(list.indexOf(job) == -1);
+}
+
+static void test_intrusive_dlinkedlist(){
+    mt19937 rng(49);
+    vector<Job> pool;
+    for(int i=0; i < 40; i++) pool.push_back(Job(i));
+    JobQueue queue;
+    JobSet all;
+    std::list<int> queueIds, allIds;
+    for(int op=0; op < 5000; op++){
+        if(rng()%2) random_intrusive_op(rng, queue, queueIds, pool);
+        else random_intrusive_op(rng, all, allIds, pool);
+        CHECK(same_ids(queue, queueIds) && same_ids(all, allIds));
+    }
+    queue.clear();
+    CHECK(queue.empty() && same_ids(all, allIds));
+    CHECK_THROWS(queue.first(), std::out_of_range);
+    CHECK_THROWS(queue.removeLast(), std::out_of_range);
+    CHECK_THROWS(queue.get(0), std::out_of_range);
+    CHECK_THROWS(queue.add(1, &pool[0]), std::out_of_range);
+
+    //a copy starts unlinked; an object destroyed while linked unlinks itself
+    {
+        Job a(100), b(101);
+        queue.add(&a);
+        queue.add(&b);
+        Job copy(a);
+        CHECK(!copy.queueHook.isLinked() && queue.size() == 2);
+        a = b;
+        CHECK(queue.contains(&a) && queue.contains(&b) && !queue.contains(&copy));
+    }
+    CHECK(queue.empty());
+
+    //free: the list deletes the objects it holds on clear
+    JobQueue owning(&JobQueue::free);
+    for(int i=0; i < 10; i++) owning.add(new Job(i));
+    owning.clear();
+    CHECK(owning.empty());
+}
+
+static void test_persistent_snapshots(){
+    mt19937 rng(1);
+    for(int round=0; round < 10; round++){
+        PersistentList<int> list;
+        vector<int> ref;
+        vector<pair<PersistentList<int>, vector<int>>> snapshots;
+        for(int op=0; op < 3000; op++){
+            int r = rng()%100;
+            if(r < 55 || ref.empty()){ int item = rng(); list.add(item); ref.push_back(item); }
+            else if(r < 70){ int i = rng()%ref.size(); int item = rng(); list.set(i, item); ref[i] = item; }
+            else if(r < 80){ int i = rng()%ref.size(); list.get(i)++; ref[i]++; }
+            else if(r < 90){ CHECK(list.removeAt(ref.size() - 1) == ref.back()); ref.pop_back(); }
+            else if(r < 93){ int i = rng()%ref.size(); CHECK(list.removeAt(i) == ref[i]); ref.erase(ref.begin() + i); }
+            else if(r < 96){ int i = rng()%(ref.size() + 1); list.add(i, 7); ref.insert(ref.begin() + i, 7); }
+            else snapshots.push_back(make_pair(list.snapshot(), ref));
+        }
+        CHECK(items_of(list) == ref);
+        for(auto& snap: snapshots) CHECK(items_of(snap.first) == snap.second);
+    }
+    PersistentList<int> list;
+    for(int i=0; i < 100000; i++) list.add(i);
+    PersistentList<int> snap = list.snapshot();
+    for(int i=0; i < 100000; i += 7) list.set(i, -1);
+    snap.set(3, 42);
+    CHECK(snap.at(7) == 7 && snap.at(3) == 42 && list.at(7) == -1 && list.at(3) == 3);
+}
+
+void test_lists(TestHarness& harness){
+    harness.run("lists/XArrayList/growth_policies", test_arraylist_growth);
+    harness.run("lists/XArrayList/sort_vs_std", test_arraylist_sort);
+    harness.run("lists/XArrayList/subList_span", test_arraylist_span);
+    harness.run("lists/XSmallList/random_vs_vector", test_small_list);
+    harness.run("lists/XDeque/wraparound", test_deque_wraparound);
+    harness.run("lists/XDeque/random_vs_std_deque", test_deque_random);
+    harness.run("lists/XHeap<2>/update_remove", test_heap_update_remove<2>);
+    harness.run("lists/XHeap<4>/update_remove", test_heap_update_remove<4>);
+    harness.run("lists/XHeap/top_k", test_heap_top_k);
+    harness.run("lists/DLinkedList/splice_split", test_dlinkedlist_splice_split);
+    harness.run("lists/DLinkedList/sort_merge", test_dlinkedlist_sort);
+    harness.run("lists/DLinkedList/cursor", test_dlinkedlist_cursor);
+    harness.run("lists/DLinkedList/cursor_outlives_list", test_dlinkedlist_cursor_outlives_list);
+    harness.run("lists/IntrusiveDLinkedList/random_vs_std_list", test_intrusive_dlinkedlist);
+    harness.run("lists/PersistentList/snapshots", test_persistent_snapshots);
+}
@@ -0,0 +1,77 @@
+/*
+ * File:   test_main.cpp
+ */
+
+#include "harness.h"
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <mutex>
+
+static std::atomic<int> g_nFailedChecks(0);
+static std::mutex g_outputMutex;
+
+void test_check(bool ok, const char* expr, const char* file, int line){
+    if(ok) return;
+    g_nFailedChecks++;
+    std::lock_guard<std::mutex> lock(g_outputMutex);
+    cerr << file << ":" << line << ": CHECK(" << expr << ") failed" << endl;
+}
+
+TestHarness::TestHarness(int argc, char** argv): m_nRun(0), m_nFailed(0) {
+    for(int idx=1; idx < argc; idx++){
+        string arg = argv[idx];
+        if(arg.rfind("--filter=", 0) == 0) m_sFilter = arg.substr(9);
+        else{
+            cerr << "usage: " << argv[0] << " [--filter=substring]" << endl;
+            exit(2);
+        }
+    }
+}
+
+bool TestHarness::enabled(string name){
+    return m_sFilter.empty() || name.find(m_sFilter) != string::npos;
+}
+
+void TestHarness::run(string name, std::function<void()> fn){
+    if(!enabled(name)) return;
+    int before = g_nFailedChecks.load();
+    bool ok = true;
+    try{
+        fn();
+    }
+    catch(std::exception& e){
+        std::lock_guard<std::mutex> lock(g_outputMutex);
+        cerr << name << ": uncaught exception: " << e.what() << endl;
+        ok = false;
+    }
+    catch(...){
+        std::lock_guard<std::mutex> lock(g_outputMutex);
+        cerr << name << ": uncaught exception" << endl;
+        ok = false;
+    }
+    if(g_nFailedChecks.load() != before) ok = false;
+    m_nRun++;
+    if(!ok) m_nFailed++;
+    cout << (ok? "[  OK  ] " : "[ FAIL ] ") << name << endl;
+}
+
+int TestHarness::finish(){
+    cout << m_nRun - m_nFailed << "/" << m_nRun << " tests passed" << endl;
+    if(m_nRun == 0){
+        cerr << "no test matches the filter" << endl;
+        return 1;
+    }
+    return m_nFailed == 0? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    TestHarness harness(argc, argv);
+    test_lists(harness);
+    test_map(harness);
+    test_concurrent(harness);
+    test_ann(harness);
+    test_util(harness);
+    return harness.finish();
+}
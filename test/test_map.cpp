@@ -0,0 +1,77 @@
+/*
+ * File:   test_map.cpp
+ *
+ * XHashMap (Robin Hood probing, backward-shift erase) against
+ * std::unordered_map.
+ */
+
+#include "harness.h"
+#include "list/XHashMap.h"
+#include <climits>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+//every key in one bucket: the longest possible probe runs
+struct ConstantHash {
+    size_t operator()(const int&) const { return 7; }
+};
+
+static void test_insert_erase_vs_reference(){
+    mt19937 rng(5);
+    for(int round=0; round < 40; round++){
+        XHashMap<string, string> map(0, 0, rng()%20);
+        unordered_map<string, string> ref;
+        int range = 1 + rng()%2000;
+        for(int op=0; op < 3000; op++){
+            int r = rng()%100;
+            string key = to_string(rng()%range);
+            string value = to_string(rng()) + string(rng()%20, 'v');
+            if(r < 35){ map.put(key, value); ref[key] = value; }
+            else if(r < 45){ map[key] += "a"; ref[key] += "a"; }
+            else if(r < 70){
+                bool present = ref.count(key) != 0;
+                CHECK(map.containsKey(key) == present);
+                if(present) CHECK(map.get(key) == ref[key]);
+                else{
+                    CHECK(map.find(key) == nullptr);
+                    CHECK_THROWS(map.get(key), std::out_of_range);
+                }
+            }
+            else if(r < 95) CHECK(map.remove(key) == (ref.erase(key) == 1));
+            else if(r < 97){ XHashMap<string, string> copy(map); map = copy; }
+            else if(r < 98) map.reserve(rng()%3000);
+            else if(rng()%10 == 0){ map.clear(); ref.clear(); }
+            CHECK(map.size() == (int)ref.size());
+            CHECK(map.getLoadFactor() <= 0.875);
+        }
+        int visited = 0;
+        for(auto it = map.begin(); it != map.end(); it++){
+            CHECK(ref.count(it.key()) == 1 && ref[it.key()] == it.value());
+            visited++;
+        }
+        CHECK(visited == (int)ref.size());
+        CHECK(map.keys().size() == visited && map.values().size() == visited);
+    }
+}
+
+static void test_colliding_keys(){
+    XHashMap<int, int, ConstantHash> map;
+    for(int i=0; i < 2000; i++) map.put(i, 2*i);
+    for(int i=0; i < 2000; i += 2) CHECK(map.remove(i));
+    for(int i=0; i < 2000; i++) CHECK(map.containsKey(i) == (i%2 == 1));
+    for(int i=1; i < 2000; i += 2) CHECK(map.get(i) == 2*i);
+    CHECK(map.size() == 1000);
+    CHECK_THROWS(map.reserve(XHASHMAP_MAX_CAPACITY), std::length_error);
+    CHECK_THROWS(map.reserve(INT_MAX), std::length_error);
+    CHECK(map.size() == 1000 && map.get(1999) == 3998);
+
+    //iterators are copyable values
+    auto it = map.begin(), copy = it;
+    CHECK(!(copy != it) && copy.key() == it.key());
+}
+
+void test_map(TestHarness& harness){
+    harness.run("map/XHashMap/insert_erase_vs_unordered_map", test_insert_erase_vs_reference);
+    harness.run("map/XHashMap/colliding_keys", test_colliding_keys);
+}
@@ -0,0 +1,93 @@
+/*
+ * File:   test_util.cpp
+ *
+ * AllocTracker counters and AllocRegion deltas. The counters themselves are
+ * checked in every build through record_alloc / record_free; the tagging of
+ * real allocations only when the library is built with ALLOC_TRACKING
+ * (alloc-tracking preset).
+ */
+
+#include "harness.h"
+#include "list/DLinkedList.h"
+#include "list/XDeque.h"
+#include "util/AllocTracker.h"
+#include <thread>
+
+//a subsystem nothing else in the tests charges, so its counters are exact
+static const int SUBSYSTEM = ALLOC_DATA;
+
+static void test_counters(){
+    AllocRegion outer("outer");
+    AllocTracker::record_alloc(SUBSYSTEM, 100);
+    AllocTracker::record_alloc(SUBSYSTEM, 50);
+    AllocTracker::record_free(SUBSYSTEM, 100);
+    AllocStats st = outer.delta(SUBSYSTEM);
+    CHECK(st.allocations == 2 && st.deallocations == 1);
+    CHECK(st.bytes_allocated == 150 && st.live_bytes == 50 && st.peak_bytes == 150);
+    {
+        //the inner peak is measured from its own start, and still reaches the outer region
+        AllocRegion inner("inner");
+        AllocTracker::record_alloc(SUBSYSTEM, 400);
+        AllocTracker::record_free(SUBSYSTEM, 400);
+        AllocStats in = inner.delta(SUBSYSTEM);
+        CHECK(in.allocations == 1 && in.live_bytes == 0 && in.peak_bytes == 400);
+        CHECK(inner.getname() == "inner");
+    }
+    st = outer.delta(SUBSYSTEM);
+    CHECK(st.allocations == 3 && st.bytes_allocated == 550 && st.peak_bytes == 450);
+    CHECK(outer.total().allocations >= 3);
+    AllocTracker::record_free(SUBSYSTEM, 50);
+    CHECK(outer.delta(SUBSYSTEM).live_bytes == 0);
+    CHECK(outer.toString().find("outer") != string::npos);
+
+    //out-of-range subsystems are charged to "other"
+    CHECK(AllocTracker::name(ALLOC_XDEQUE) == "XDeque" && AllocTracker::name(-1) == "?");
+    CHECK(AllocTracker::name(ALLOC_NUM_SUBSYSTEMS) == "total");
+}
+
+static void test_tags(){
+    int before = AllocTracker::current();
+    {
+        AllocTag tag(ALLOC_XDEQUE);
+        CHECK(AllocTracker::current() == ALLOC_XDEQUE);
+        {
+            AllocTag inner(ALLOC_ANN);
+            CHECK(AllocTracker::current() == ALLOC_ANN);
+        }
+        CHECK(AllocTracker::current() == ALLOC_XDEQUE);
+    }
+    CHECK(AllocTracker::current() == before);
+    //the tag is per thread
+    std::thread other([]{ CHECK(AllocTracker::current() == ALLOC_OTHER); });
+    AllocTag tag(ALLOC_ANN);
+    other.join();
+}
+
+//with ALLOC_TRACKING, container storage lands in its own subsystem, and a
+//block freed on another thread is credited back to the subsystem it came from
+static void test_tracked_containers(){
+    AllocRegion region;
+    XDeque<int>* deque = new XDeque<int>(0, 0, 1024);
+    for(int i=0; i < 5000; i++) deque->addLast(i);
+    DLinkedList<int> list;
+    for(int i=0; i < 100; i++) list.add(i);
+    AllocStats xd = region.delta(ALLOC_XDEQUE), dl = region.delta(ALLOC_DLINKEDLIST);
+    if(!AllocTracker::enabled()){
+        CHECK(xd.allocations == 0 && dl.allocations == 0);
+        delete deque;
+        return;
+    }
+    CHECK(xd.allocations >= 1 && xd.bytes_allocated >= 8192*sizeof(int));
+    CHECK(xd.live_bytes == 8192*sizeof(int));
+    CHECK(dl.allocations >= 100);
+    std::thread freer([deque]{ delete deque; });
+    freer.join();
+    CHECK(region.delta(ALLOC_XDEQUE).live_bytes == 0);
+    CHECK(region.delta(ALLOC_XARRAYLIST).allocations == 0);
+}
+
+void test_util(TestHarness& harness){
+    harness.run("util/AllocTracker/counters", test_counters);
+    harness.run("util/AllocTracker/tags", test_tags);
+    harness.run("util/AllocTracker/tracked_containers", test_tracked_containers);
+}